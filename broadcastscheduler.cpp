@@ -0,0 +1,69 @@
+#include "broadcastscheduler.h"
+
+#include <QRandomGenerator>
+
+BroadcastScheduler::BroadcastScheduler(QObject *parent)
+    : QObject(parent)
+{
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, &BroadcastScheduler::onTimeout);
+}
+
+void BroadcastScheduler::setIntervals(int initialMs, int maxMs)
+{
+    m_initialMs = qMax(1, initialMs);
+    m_maxMs = qMax(m_initialMs, maxMs);
+}
+
+void BroadcastScheduler::setJitter(double fraction)
+{
+    m_jitter = qBound(0.0, fraction, 1.0);
+}
+
+void BroadcastScheduler::setBudget(int maxProbes, int maxDurationMs)
+{
+    m_maxProbes = qMax(1, maxProbes);
+    m_maxDurationMs = qMax(0, maxDurationMs);
+}
+
+void BroadcastScheduler::start()
+{
+    m_sent = 0;
+    m_interval = m_initialMs;
+    m_clock.start();
+    m_active = true;
+    // 首包在 [0, initial) 内随机延迟，打散同时启动的实例
+    m_timer->start(int(QRandomGenerator::global()->bounded(m_initialMs)));
+}
+
+void BroadcastScheduler::stop()
+{
+    m_active = false;
+    m_timer->stop();
+}
+
+void BroadcastScheduler::onTimeout()
+{
+    if (m_sent >= m_maxProbes || m_clock.elapsed() >= m_maxDurationMs) {
+        m_active = false;
+        emit finished();
+        return;
+    }
+
+    ++m_sent;
+    emit probe();
+
+    // probe() 的接收方可能已调用 stop()
+    if (!m_active) {
+        return;
+    }
+    m_timer->start(jittered(m_interval));
+    m_interval = qMin(m_interval * 2, m_maxMs);
+}
+
+int BroadcastScheduler::jittered(int intervalMs) const
+{
+    const double spread = (QRandomGenerator::global()->generateDouble() * 2.0 - 1.0) * m_jitter;
+    return qMax(1, int(intervalMs * (1.0 + spread)));
+}
@@ -0,0 +1,53 @@
+#ifndef BROADCASTSCHEDULER_H
+#define BROADCASTSCHEDULER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+
+// 广播探测调度：先快速探测，随后按指数退避拉长间隔并加入随机抖动，
+// 避免同时启动的多个实例广播对齐；次数和总时长受预算限制
+class BroadcastScheduler : public QObject {
+    Q_OBJECT
+
+public:
+    explicit BroadcastScheduler(QObject *parent = nullptr);
+
+    void setIntervals(int initialMs, int maxMs);
+    // 抖动比例，0.25 表示在 ±25% 范围内随机
+    void setJitter(double fraction);
+    // 最多发送 maxProbes 次，且不超过 maxDurationMs
+    void setBudget(int maxProbes, int maxDurationMs);
+
+    void start();
+    void stop();
+    bool isRunning() const { return m_active; }
+
+    int probesSent() const { return m_sent; }
+
+signals:
+    void probe();
+    // 预算耗尽
+    void finished();
+
+private slots:
+    void onTimeout();
+
+private:
+    int jittered(int intervalMs) const;
+
+    QTimer *m_timer;
+    QElapsedTimer m_clock;
+
+    int m_initialMs = 100;
+    int m_maxMs = 8000;
+    double m_jitter = 0.25;
+    int m_maxProbes = 30;
+    int m_maxDurationMs = 120000;
+
+    int m_interval = 0;
+    int m_sent = 0;
+    bool m_active = false;
+};
+
+#endif // BROADCASTSCHEDULER_H
@@ -0,0 +1,113 @@
+#include "connectionmanager.h"
+#include "discoverymetrics.h"
+
+// 时间轮节拍，空闲超时精度为一个节拍
+constexpr int WHEEL_TICK_MS = 1000;
+
+ConnectionManager::ConnectionManager(QObject *parent)
+    : QObject(parent)
+{
+    m_server = new QTcpServer(this);
+    // QTcpServer 每次可读通知会连续 accept 到 maxPendingConnections 为止；限制为 1，
+    // 达到上限时 pauseAccepting 后其余连接留在内核 backlog，而不是被 accept 后再复位
+    m_server->setMaxPendingConnections(1);
+    connect(m_server, &QTcpServer::newConnection, this, &ConnectionManager::onNewConnection);
+
+    m_wheelTimer = new QTimer(this);
+    m_wheelTimer->setInterval(WHEEL_TICK_MS);
+    connect(m_wheelTimer, &QTimer::timeout, this, [this]() {
+        m_wheel.advance([this](QTcpSocket *client) {
+            FINDER_TRACE() << "Tcp idle timeout" << client->peerAddress();
+            countMetric(MetricCounter::TcpIdleTimeouts);
+            client->close();
+            release(client);
+        });
+    });
+}
+
+void ConnectionManager::setMaxClients(int maxClients)
+{
+    m_maxClients = qMax(1, maxClients);
+}
+
+void ConnectionManager::setIdleTimeout(int ms)
+{
+    m_idleTicks = qMax(1, (ms + WHEEL_TICK_MS - 1) / WHEEL_TICK_MS);
+}
+
+bool ConnectionManager::listen(const QHostAddress &address, quint16 port)
+{
+    if (!m_server->listen(address, port)) {
+        qWarning() << "Tcp listen failed:" << m_server->errorString();
+        return false;
+    }
+    m_wheelTimer->start();
+    return true;
+}
+
+bool ConnectionManager::listen(qintptr descriptor)
+{
+    if (!m_server->setSocketDescriptor(descriptor)) {
+        qWarning() << "Tcp listen failed:" << m_server->errorString();
+        return false;
+    }
+    m_wheelTimer->start();
+    return true;
+}
+
+void ConnectionManager::close()
+{
+    m_server->close();
+    m_wheelTimer->stop();
+    const QSet<QTcpSocket *> clients = m_clients;
+    for (QTcpSocket *client : clients) {
+        client->abort();
+        release(client);
+    }
+}
+
+void ConnectionManager::onNewConnection()
+{
+    while (m_server->hasPendingConnections()) {
+        QTcpSocket *client = m_server->nextPendingConnection();
+        if (m_clients.size() >= m_maxClients) {
+            // 兜底：已被 QTcpServer accept 的超限连接只能复位，计入 TcpRejected
+            client->abort();
+            client->deleteLater();
+            countMetric(MetricCounter::TcpRejected);
+            m_server->pauseAccepting();
+            continue;
+        }
+
+        m_clients.insert(client);
+        countMetric(MetricCounter::TcpAccepted);
+        m_wheel.schedule(client, m_idleTicks);
+        connect(client, &QTcpSocket::readyRead, this, [this, client]() {
+            m_wheel.schedule(client, m_idleTicks);
+            emit clientReadyRead(client);
+        });
+        connect(client, &QTcpSocket::disconnected, this, [this, client]() {
+            release(client);
+        });
+        emit clientConnected(client);
+
+        if (m_clients.size() >= m_maxClients) {
+            m_server->pauseAccepting();
+        }
+    }
+}
+
+void ConnectionManager::release(QTcpSocket *client)
+{
+    if (!m_clients.remove(client)) {
+        return;
+    }
+    m_wheel.cancel(client);
+    countMetric(MetricCounter::TcpClosed);
+    emit clientClosed(client);
+    client->disconnect(this);
+    client->deleteLater();
+    if (m_clients.size() < m_maxClients) {
+        m_server->resumeAccepting();
+    }
+}
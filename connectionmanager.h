@@ -0,0 +1,54 @@
+#ifndef CONNECTIONMANAGER_H
+#define CONNECTIONMANAGER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QSet>
+#include <QTimer>
+
+#include "timerwheel.h"
+
+// TCP 连接管理：限制并发客户端数量，空闲超时统一由一个时间轮处理，
+// 连接断开后立即释放套接字
+class ConnectionManager : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ConnectionManager(QObject *parent = nullptr);
+
+    void setMaxClients(int maxClients);
+    int maxClients() const { return m_maxClients; }
+    void setIdleTimeout(int ms);
+
+    bool listen(const QHostAddress &address, quint16 port);
+    // 在已 listen() 的描述符上接受连接（如 SO_REUSEPORT 套接字），之后由本对象关闭
+    bool listen(qintptr descriptor);
+    void close();
+
+    int clientCount() const { return m_clients.size(); }
+
+    // 有数据到达时由使用方调用 readAll() 等读取；空闲计时已自动刷新
+signals:
+    void clientConnected(QTcpSocket *client);
+    void clientReadyRead(QTcpSocket *client);
+    // 客户端即将释放，使用方应清理与之关联的状态
+    void clientClosed(QTcpSocket *client);
+
+private slots:
+    void onNewConnection();
+
+private:
+    void release(QTcpSocket *client);
+
+    QTcpServer *m_server;
+    QSet<QTcpSocket *> m_clients;
+    TimerWheel<QTcpSocket *> m_wheel;
+    QTimer *m_wheelTimer;
+
+    int m_maxClients = 256;
+    int m_idleTicks = 60;
+};
+
+#endif // CONNECTIONMANAGER_H
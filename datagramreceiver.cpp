@@ -0,0 +1,224 @@
+#include "datagramreceiver.h"
+#include "discoverymetrics.h"
+
+#ifdef Q_OS_LINUX
+#include <sys/socket.h>
+#include <netinet/in.h>
+#endif
+
+constexpr int RECV_RING = 64;
+constexpr int RECV_BUFFER = 2048;
+// 应答只是少量帧，更大的应答不排队直接发送
+constexpr int REPLY_BUFFER = 512;
+
+#ifdef Q_OS_LINUX
+struct DatagramReceiver::RecvBatch {
+    mmsghdr msgs[RECV_RING];
+    iovec iov[RECV_RING];
+    sockaddr_storage addrs[RECV_RING];
+
+    // 待发应答：每个接收的数据报至多一个应答，目的地址直接复制接收到的 sockaddr
+    mmsghdr replyMsgs[RECV_RING];
+    iovec replyIov[RECV_RING];
+    sockaddr_storage replyAddrs[RECV_RING];
+    char replies[RECV_RING][REPLY_BUFFER];
+};
+
+namespace {
+// 从 IPv4 或 IPv4 映射的 IPv6 地址中取出主机序地址；纯 IPv6 发送方返回 0 并填写 view 的 IPv6 字段
+quint32 senderIpv4(const sockaddr_storage &addr, quint16 *port, DatagramView *view)
+{
+    if (addr.ss_family == AF_INET) {
+        const sockaddr_in *in = reinterpret_cast<const sockaddr_in *>(&addr);
+        *port = ntohs(in->sin_port);
+        return ntohl(in->sin_addr.s_addr);
+    }
+    if (addr.ss_family == AF_INET6) {
+        const sockaddr_in6 *in6 = reinterpret_cast<const sockaddr_in6 *>(&addr);
+        *port = ntohs(in6->sin6_port);
+        if (IN6_IS_ADDR_V4MAPPED(&in6->sin6_addr)) {
+            quint32 be;
+            std::memcpy(&be, &in6->sin6_addr.s6_addr[12], 4);
+            return ntohl(be);
+        }
+        view->senderV6 = in6->sin6_addr.s6_addr;
+        view->senderScope = in6->sin6_scope_id;
+    }
+    return 0;
+}
+}
+#else
+struct DatagramReceiver::RecvBatch {};
+#endif
+
+DatagramReceiver::DatagramReceiver(QUdpSocket *socket, Handler handler, QObject *parent)
+    : QObject(parent)
+    , m_socket(socket)
+    , m_handler(std::move(handler))
+{
+    m_ring.resize(RECV_RING * RECV_BUFFER);
+}
+
+DatagramReceiver::~DatagramReceiver() = default;
+
+void DatagramReceiver::start()
+{
+    m_stopped = false;
+#ifdef Q_OS_LINUX
+    const qintptr fd = m_socket->socketDescriptor();
+    if (fd != -1) {
+        // 消息头一次性指向环形缓冲区，之后每次接收只重置长度字段
+        m_batch.reset(new RecvBatch);
+        std::memset(m_batch.get(), 0, sizeof(RecvBatch));
+        for (int i = 0; i < RECV_RING; ++i) {
+            m_batch->iov[i].iov_base = m_ring.data() + i * RECV_BUFFER;
+            m_batch->iov[i].iov_len = RECV_BUFFER;
+            m_batch->msgs[i].msg_hdr.msg_name = &m_batch->addrs[i];
+            m_batch->msgs[i].msg_hdr.msg_iov = &m_batch->iov[i];
+            m_batch->msgs[i].msg_hdr.msg_iovlen = 1;
+            m_batch->replyIov[i].iov_base = m_batch->replies[i];
+            m_batch->replyMsgs[i].msg_hdr.msg_name = &m_batch->replyAddrs[i];
+            m_batch->replyMsgs[i].msg_hdr.msg_iov = &m_batch->replyIov[i];
+            m_batch->replyMsgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        // 自行监听可读事件；QUdpSocket 的 readyRead 不再使用
+        m_notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+        connect(m_notifier, &QSocketNotifier::activated, this, [this]() { drain(); });
+        drain();
+        return;
+    }
+#endif
+    connect(m_socket, &QUdpSocket::readyRead, this, [this]() { drain(); });
+}
+
+void DatagramReceiver::stop()
+{
+    m_stopped = true;
+    if (m_notifier) {
+        m_notifier->setEnabled(false);
+    }
+    disconnect(m_socket, nullptr, this, nullptr);
+}
+
+int DatagramReceiver::drain()
+{
+#ifdef Q_OS_LINUX
+    if (m_notifier) {
+        return drainBatched(int(m_notifier->socket()));
+    }
+#endif
+    int count = 0;
+    while (m_socket->hasPendingDatagrams()) {
+        quint16 port = 0;
+        const qint64 size = m_socket->readDatagram(m_ring.data(), RECV_BUFFER, &m_sender, &port);
+        if (size < 0) {
+            break;
+        }
+        bool ok = false;
+        DatagramView view;
+        view.data = m_ring.constData();
+        view.size = int(size);
+        view.senderV4 = m_sender.toIPv4Address(&ok);
+        if (!ok && m_sender.protocol() == QAbstractSocket::IPv6Protocol) {
+            m_senderV6 = m_sender.toIPv6Address();
+            view.senderV6 = m_senderV6.c;
+            view.senderScope = m_sender.scopeId().toUInt();
+        }
+        view.senderPort = port;
+        m_handler(view);
+        ++count;
+        if (m_stopped) {
+            break;
+        }
+    }
+    m_received += quint64(count);
+    return count;
+}
+
+bool DatagramReceiver::queueReply(const QByteArray &reply)
+{
+#ifdef Q_OS_LINUX
+    if (!m_batchReplies || m_current < 0 || reply.size() > REPLY_BUFFER || m_pendingReplies >= RECV_RING) {
+        return false;
+    }
+    const int slot = m_pendingReplies++;
+    std::memcpy(m_batch->replies[slot], reply.constData(), size_t(reply.size()));
+    m_batch->replyAddrs[slot] = m_batch->addrs[m_current];
+    mmsghdr &msg = m_batch->replyMsgs[slot];
+    msg.msg_hdr.msg_namelen = m_batch->msgs[m_current].msg_hdr.msg_namelen;
+    m_batch->replyIov[slot].iov_len = size_t(reply.size());
+    return true;
+#else
+    Q_UNUSED(reply);
+    return false;
+#endif
+}
+
+void DatagramReceiver::flushReplies(int fd)
+{
+#ifdef Q_OS_LINUX
+    int offset = 0;
+    while (offset < m_pendingReplies) {
+        const int n = ::sendmmsg(fd, m_batch->replyMsgs + offset, unsigned(m_pendingReplies - offset),
+                                 MSG_DONTWAIT);
+        if (n > 0) {
+            offset += n;
+            countMetric(MetricCounter::RepliesSent, quint64(n));
+            continue;
+        }
+        // 发送缓冲区满时丢弃剩余应答，设备会在下个心跳周期重发
+        countMetric(MetricCounter::SendErrors, quint64(m_pendingReplies - offset));
+        break;
+    }
+    m_pendingReplies = 0;
+#else
+    Q_UNUSED(fd);
+#endif
+}
+
+int DatagramReceiver::drainBatched(int fd)
+{
+#ifdef Q_OS_LINUX
+    mmsghdr *msgs = m_batch->msgs;
+    int count = 0;
+    for (;;) {
+        for (int i = 0; i < RECV_RING; ++i) {
+            msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+            msgs[i].msg_hdr.msg_flags = 0;
+        }
+        const int n = ::recvmmsg(fd, msgs, RECV_RING, MSG_DONTWAIT, nullptr);
+        if (n <= 0) {
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+                continue;
+            }
+            DatagramView view;
+            view.data = m_ring.constData() + i * RECV_BUFFER;
+            view.size = int(msgs[i].msg_len);
+            view.senderV4 = senderIpv4(m_batch->addrs[i], &view.senderPort, &view);
+            m_current = i;
+            m_handler(view);
+            // 回调中关闭了监听：套接字随后关闭，丢弃本批剩余数据报与待发应答
+            if (m_stopped) {
+                m_current = -1;
+                m_pendingReplies = 0;
+                m_received += quint64(count + i + 1);
+                return count + i + 1;
+            }
+        }
+        m_current = -1;
+        flushReplies(fd);
+        count += n;
+        if (n < RECV_RING) {
+            break;
+        }
+    }
+    m_received += quint64(count);
+    return count;
+#else
+    Q_UNUSED(fd);
+    return 0;
+#endif
+}
@@ -0,0 +1,102 @@
+#ifndef DATAGRAMRECEIVER_H
+#define DATAGRAMRECEIVER_H
+
+#include <QObject>
+#include <QUdpSocket>
+#include <QSocketNotifier>
+#include <QByteArray>
+#include <QHostAddress>
+
+#include <cstring>
+#include <functional>
+#include <memory>
+
+#include "deviceaddress.h"
+
+// 指向接收环形缓冲区的数据报视图，仅在回调期间有效
+struct DatagramView {
+    const char *data = nullptr;
+    int size = 0;
+    quint32 senderV4 = 0;       // 非 IPv4 发送方为 0
+    const quint8 *senderV6 = nullptr;   // IPv6 发送方的 16 字节地址，IPv4 发送方为空
+    quint32 senderScope = 0;    // IPv6 链路本地地址的接口索引
+    quint16 senderPort = 0;
+
+    bool hasSender() const { return senderV4 != 0 || senderV6 != nullptr; }
+
+    DeviceAddress senderAddress() const {
+        return senderV6 ? DeviceAddress::fromIpv6(senderV6) : DeviceAddress::fromIpv4(senderV4);
+    }
+
+    // 用于回复的地址，链路本地 IPv6 带上接口
+    QHostAddress senderHost() const {
+        if (!senderV6) {
+            return QHostAddress(senderV4);
+        }
+        QHostAddress host(senderV6);
+        if (senderScope != 0) {
+            host.setScopeId(QString::number(senderScope));
+        }
+        return host;
+    }
+
+    bool equals(const QByteArray &message) const {
+        return size == message.size() && std::memcmp(data, message.constData(), size_t(size)) == 0;
+    }
+};
+
+// UDP 接收路径：预分配一组缓冲区循环使用，Linux 上用 recvmmsg 一次读空套接字，
+// 每个数据报不产生堆分配也不打日志
+class DatagramReceiver : public QObject {
+    Q_OBJECT
+
+public:
+    using Handler = std::function<void(const DatagramView &)>;
+
+    explicit DatagramReceiver(QUdpSocket *socket, Handler handler, QObject *parent = nullptr);
+    ~DatagramReceiver() override;
+
+    void setHandler(Handler handler) { m_handler = std::move(handler); }
+
+    // 批量应答：开启后回调中经 queueReply() 提交的应答在本批数据报处理完后
+    // 用一次 sendmmsg 发出。仅 Linux 批量接收路径有效
+    void setBatchReplies(bool enabled) { m_batchReplies = enabled; }
+
+    // 只能在回调期间调用，应答发往当前数据报的发送方；
+    // 返回 false 表示不能排队（未开启、非批量路径或应答过大），调用方应直接发送
+    bool queueReply(const QByteArray &reply);
+
+    // 套接字绑定之后调用
+    void start();
+    // 不再接收；套接字关闭前调用，之后可安全地 deleteLater。
+    // 可在回调中调用，本批剩余的数据报不再交给回调
+    void stop();
+
+    // 读空套接字，返回处理的数据报数
+    int drain();
+
+    quint64 received() const { return m_received; }
+
+private:
+    struct RecvBatch;
+
+    int drainBatched(int fd);
+    void flushReplies(int fd);
+
+    QUdpSocket *m_socket;
+    Handler m_handler;
+    QSocketNotifier *m_notifier = nullptr;
+
+    QByteArray m_ring;          // RECV_RING 个 RECV_BUFFER 大小的缓冲区
+    std::unique_ptr<RecvBatch> m_batch;     // recvmmsg 所需的消息头与地址
+    QHostAddress m_sender;      // 非 Linux 路径复用
+    Q_IPV6ADDR m_senderV6;
+    quint64 m_received = 0;
+
+    bool m_batchReplies = false;
+    bool m_stopped = false;
+    int m_current = -1;         // 回调中的数据报在本批中的下标，回调外为 -1
+    int m_pendingReplies = 0;
+};
+
+#endif // DATAGRAMRECEIVER_H
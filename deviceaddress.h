@@ -0,0 +1,72 @@
+#ifndef DEVICEADDRESS_H
+#define DEVICEADDRESS_H
+
+#include <QHostAddress>
+#include <QHash>
+#include <QtEndian>
+#include <QMetaType>
+
+#include <cstring>
+
+// 设备地址键：128 位，IPv4 以 IPv4 映射形式（::ffff:a.b.c.d）保存，
+// 使 IPv4 与 IPv6 设备共用同一张哈希表
+struct DeviceAddress {
+    quint64 hi = 0;     // 网络序前 8 字节（按大端解释）
+    quint64 lo = 0;
+
+    static DeviceAddress fromIpv4(quint32 ipv4) {
+        DeviceAddress address;
+        address.lo = Q_UINT64_C(0x0000ffff00000000) | ipv4;
+        return address;
+    }
+
+    // bytes 为 16 字节网络序地址
+    static DeviceAddress fromIpv6(const quint8 *bytes) {
+        DeviceAddress address;
+        address.hi = qFromBigEndian<quint64>(bytes);
+        address.lo = qFromBigEndian<quint64>(bytes + 8);
+        return address;
+    }
+
+    static DeviceAddress fromHostAddress(const QHostAddress &host) {
+        bool ok = false;
+        const quint32 ipv4 = host.toIPv4Address(&ok);
+        if (ok) {
+            return fromIpv4(ipv4);
+        }
+        if (host.protocol() == QAbstractSocket::IPv6Protocol) {
+            const Q_IPV6ADDR bytes = host.toIPv6Address();
+            return fromIpv6(bytes.c);
+        }
+        return DeviceAddress();
+    }
+
+    bool isNull() const { return hi == 0 && lo == 0; }
+    bool isIpv4() const { return hi == 0 && (lo >> 32) == 0xffff; }
+    quint32 toIpv4() const { return isIpv4() ? quint32(lo) : 0; }
+
+    QHostAddress toHostAddress() const {
+        if (isIpv4()) {
+            return QHostAddress(toIpv4());
+        }
+        quint8 bytes[16];
+        qToBigEndian<quint64>(hi, bytes);
+        qToBigEndian<quint64>(lo, bytes + 8);
+        return QHostAddress(bytes);
+    }
+
+    bool operator==(const DeviceAddress &other) const { return hi == other.hi && lo == other.lo; }
+    bool operator!=(const DeviceAddress &other) const { return !(*this == other); }
+};
+Q_DECLARE_METATYPE(DeviceAddress)
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+inline size_t qHash(const DeviceAddress &key, size_t seed = 0) noexcept
+#else
+inline uint qHash(const DeviceAddress &key, uint seed = 0) noexcept
+#endif
+{
+    return qHash(key.hi ^ (key.lo * Q_UINT64_C(0x9E3779B97F4A7C15)), seed);
+}
+
+#endif // DEVICEADDRESS_H
@@ -0,0 +1,128 @@
+#include "devicecache.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QDebug>
+
+#include <algorithm>
+
+constexpr quint32 CACHE_MAGIC = 0x4D544443; // "MTDC"
+constexpr quint8 CACHE_VERSION = 1;
+// 只保留最近的若干设备，限制文件大小和启动探测量
+constexpr int CACHE_MAX_DEVICES = 256;
+constexpr int MAC_LENGTH = 6;
+
+DeviceCache::DeviceCache(const QString &path)
+    : m_path(path)
+{
+}
+
+QString DeviceCache::defaultPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+           + QStringLiteral("/devices.cache");
+}
+
+bool DeviceCache::load()
+{
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint8 version = 0;
+    quint32 count = 0;
+    in >> magic >> version >> count;
+    if (magic != CACHE_MAGIC || version != CACHE_VERSION) {
+        qWarning() << "Ignoring device cache with unknown format:" << m_path;
+        return false;
+    }
+
+    m_devices.clear();
+    for (quint32 i = 0; i < count && !in.atEnd(); ++i) {
+        CachedDevice device;
+        quint8 method = 0;
+        char mac[MAC_LENGTH];
+        in >> device.ipv4;
+        in.readRawData(mac, MAC_LENGTH);
+        in >> method >> device.lastSeen;
+        if (in.status() != QDataStream::Ok) {
+            break;
+        }
+        if (std::any_of(mac, mac + MAC_LENGTH, [](char c) { return c != 0; })) {
+            device.mac = QByteArray(mac, MAC_LENGTH);
+        }
+        device.method = static_cast<DiscoveryMethod>(method);
+        m_devices.insert(device.ipv4, device);
+    }
+    m_dirty = false;
+    return true;
+}
+
+bool DeviceCache::save()
+{
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+    QSaveFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to write device cache:" << file.errorString();
+        return false;
+    }
+
+    QList<CachedDevice> list = devices();
+    if (list.size() > CACHE_MAX_DEVICES) {
+        list = list.mid(0, CACHE_MAX_DEVICES);
+    }
+
+    QDataStream out(&file);
+    out << CACHE_MAGIC << CACHE_VERSION << quint32(list.size());
+    const char zeroMac[MAC_LENGTH] = {};
+    for (const CachedDevice &device : list) {
+        out << device.ipv4;
+        if (device.mac.size() == MAC_LENGTH) {
+            out.writeRawData(device.mac.constData(), MAC_LENGTH);
+        } else {
+            out.writeRawData(zeroMac, MAC_LENGTH);
+        }
+        out << quint8(device.method) << device.lastSeen;
+    }
+
+    if (!file.commit()) {
+        return false;
+    }
+    m_dirty = false;
+    return true;
+}
+
+void DeviceCache::record(const QHostAddress &ip, DiscoveryMethod method, const QByteArray &mac)
+{
+    bool ok = false;
+    const quint32 ipv4 = ip.toIPv4Address(&ok);
+    if (!ok) {
+        return;
+    }
+
+    CachedDevice &device = m_devices[ipv4];
+    device.ipv4 = ipv4;
+    if (mac.size() == MAC_LENGTH) {
+        device.mac = mac;
+    }
+    device.method = method;
+    device.lastSeen = QDateTime::currentMSecsSinceEpoch();
+    m_dirty = true;
+}
+
+QList<CachedDevice> DeviceCache::devices() const
+{
+    QList<CachedDevice> list = m_devices.values();
+    std::sort(list.begin(), list.end(), [](const CachedDevice &a, const CachedDevice &b) {
+        return a.lastSeen > b.lastSeen;
+    });
+    return list;
+}
@@ -0,0 +1,62 @@
+#ifndef DEVICECACHE_H
+#define DEVICECACHE_H
+
+#include <QHostAddress>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QString>
+
+// 设备是通过哪种方式被发现的
+enum class DiscoveryMethod : quint8 {
+    Unknown = 0,
+    Broadcast = 1,
+    Mdns = 2,
+    UnicastScan = 3,
+    Cache = 4,
+    Ipv6 = 5,
+};
+
+inline const char *discoveryMethodName(DiscoveryMethod method) {
+    switch (method) {
+    case DiscoveryMethod::Broadcast: return "broadcast";
+    case DiscoveryMethod::Mdns: return "mdns";
+    case DiscoveryMethod::UnicastScan: return "scan";
+    case DiscoveryMethod::Cache: return "cache";
+    case DiscoveryMethod::Ipv6: return "ipv6";
+    default: return "unknown";
+    }
+}
+
+struct CachedDevice {
+    quint32 ipv4 = 0;
+    QByteArray mac;         // 6 字节，未知时为空
+    DiscoveryMethod method = DiscoveryMethod::Unknown;
+    qint64 lastSeen = 0;    // ms since epoch
+};
+
+// 已发现设备的本地缓存，启动时优先单播探测上次的地址。
+// 文件格式：魔数 + 版本 + 条数，每条固定 19 字节（IP、MAC、方式、时间）
+class DeviceCache {
+public:
+    explicit DeviceCache(const QString &path = defaultPath());
+
+    static QString defaultPath();
+
+    bool load();
+    bool save();
+    bool isDirty() const { return m_dirty; }
+
+    void record(const QHostAddress &ip, DiscoveryMethod method, const QByteArray &mac = QByteArray());
+
+    // 按最近出现时间排序
+    QList<CachedDevice> devices() const;
+    bool isEmpty() const { return m_devices.isEmpty(); }
+
+private:
+    QString m_path;
+    QHash<quint32, CachedDevice> m_devices;
+    bool m_dirty = false;
+};
+
+#endif // DEVICECACHE_H
@@ -0,0 +1,120 @@
+#include "deviceexport.h"
+
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+namespace {
+
+QByteArray isoTime(qint64 ms)
+{
+    return QDateTime::fromMSecsSinceEpoch(ms).toUTC().toString(Qt::ISODateWithMs).toLatin1();
+}
+
+QByteArray csvLine(const DeviceRecord &record)
+{
+    QByteArray ports;
+    for (quint16 port : record.openPorts) {
+        if (!ports.isEmpty()) {
+            ports += ' ';
+        }
+        ports += QByteArray::number(port);
+    }
+    // 各字段都不含逗号或引号，无需转义
+    QByteArray line = record.address.toHostAddress().toString().toLatin1();
+    line += ',';
+    line += discoveryMethodName(record.method);
+    line += ',';
+    line += QByteArray::number(record.rttUs);
+    line += ',';
+    line += deviceIdText(record.deviceId).toLatin1();
+    line += ',';
+    line += isoTime(record.firstSeen);
+    line += ',';
+    line += isoTime(record.lastSeen);
+    line += ',';
+    line += QByteArray::number(record.heartbeats);
+    line += ',';
+    line += ports;
+    line += '\n';
+    return line;
+}
+
+QByteArray jsonLine(const DeviceRecord &record)
+{
+    QJsonArray ports;
+    for (quint16 port : record.openPorts) {
+        ports.append(int(port));
+    }
+    QJsonObject object;
+    object.insert(QStringLiteral("ip"), record.address.toHostAddress().toString());
+    object.insert(QStringLiteral("method"), QLatin1String(discoveryMethodName(record.method)));
+    object.insert(QStringLiteral("rtt_us"), double(record.rttUs));
+    object.insert(QStringLiteral("device_id"), deviceIdText(record.deviceId));
+    object.insert(QStringLiteral("first_seen"), QString::fromLatin1(isoTime(record.firstSeen)));
+    object.insert(QStringLiteral("last_seen"), QString::fromLatin1(isoTime(record.lastSeen)));
+    object.insert(QStringLiteral("heartbeats"), double(record.heartbeats));
+    object.insert(QStringLiteral("open_ports"), ports);
+    return QJsonDocument(object).toJson(QJsonDocument::Compact);
+}
+
+}
+
+namespace DeviceExport {
+
+Format formatForPath(const QString &path)
+{
+    return path.endsWith(QLatin1String(".json"), Qt::CaseInsensitive) ? Format::Json : Format::Csv;
+}
+
+Writer::Writer(QIODevice *device, Format format)
+    : m_device(device)
+    , m_format(format)
+{
+}
+
+bool Writer::begin()
+{
+    m_started = true;
+    const char *header = m_format == Format::Csv
+        ? "ip,method,rtt_us,device_id,first_seen,last_seen,heartbeats,open_ports\n"
+        : "[\n";
+    m_ok = m_device->write(header) >= 0;
+    return m_ok;
+}
+
+bool Writer::append(const DeviceRecord &record)
+{
+    if (!m_started && !begin()) {
+        return false;
+    }
+    if (!m_ok) {
+        return false;
+    }
+    if (m_format == Format::Csv) {
+        m_ok = m_device->write(csvLine(record)) >= 0;
+    } else {
+        if (m_count > 0) {
+            m_ok = m_device->write(",\n") >= 0;
+        }
+        m_ok = m_ok && m_device->write(jsonLine(record)) >= 0;
+    }
+    if (m_ok) {
+        ++m_count;
+    }
+    return m_ok;
+}
+
+bool Writer::finish()
+{
+    if (!m_started && !begin()) {
+        return false;
+    }
+    if (m_ok && m_format == Format::Json) {
+        m_ok = m_device->write(m_count > 0 ? "\n]\n" : "]\n") >= 0;
+    }
+    return m_ok;
+}
+
+}
@@ -0,0 +1,73 @@
+#ifndef DEVICEEXPORT_H
+#define DEVICEEXPORT_H
+
+#include <QString>
+#include <QIODevice>
+#include <QSaveFile>
+
+#include "deviceregistry.h"
+
+namespace DeviceExport {
+
+enum class Format {
+    Csv,
+    Json,
+};
+
+// 按扩展名选择格式：.json 为 JSON，其余为 CSV
+Format formatForPath(const QString &path);
+
+// 逐条写出设备记录：每台设备只格式化一行后立即写入，JSON 数组也逐个对象写出，
+// 导出过程中不构造整份文档
+class Writer {
+public:
+    Writer(QIODevice *device, Format format);
+
+    bool append(const DeviceRecord &record);
+    // 写入结尾（JSON 的 ]），之后不能再 append
+    bool finish();
+
+    int count() const { return m_count; }
+
+private:
+    bool begin();
+
+    QIODevice *m_device;
+    Format m_format;
+    bool m_ok = true;
+    bool m_started = false;
+    int m_count = 0;
+};
+
+// 写入临时文件，成功后替换 path；forEach(visit) 对每条记录调用 visit(record)。
+// 返回导出的设备数，失败返回 -1
+template <typename ForEach>
+int writeFile(const QString &path, ForEach forEach, QString *error = nullptr)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return -1;
+    }
+    Writer writer(&file, formatForPath(path));
+    forEach([&writer](const DeviceRecord &record) { writer.append(record); });
+    if (!writer.finish() || !file.commit()) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return -1;
+    }
+    return writer.count();
+}
+
+// 直接遍历设备表导出，不复制整张表；须在设备表所在线程调用
+inline int writeFile(const DeviceRegistry &registry, const QString &path, QString *error = nullptr)
+{
+    return writeFile(path, [&registry](auto visit) { registry.forEach(visit); }, error);
+}
+
+}
+
+#endif // DEVICEEXPORT_H
@@ -1,4 +1,8 @@
 #include "devicefinder.h"
+#include "discoverymetrics.h"
+#include "networkworker.h"
+
+#include <QDateTime>
 
 DeviceFinder::DeviceFinder(const QVector<bool> m,
                            const QString ip,
@@ -7,281 +11,506 @@ DeviceFinder::DeviceFinder(const QVector<bool> m,
                            const quint16 targetUdp,
                            QObject *parent )
     :
-    method(m)
-    ,m_tcp_listen(tcpPort)
-    ,m_udp_listen(udpPort)
+    QObject(parent)
+    ,method(m)
     ,m_targetIp(ip)
-    ,QObject(parent)
+    ,m_udp_target(targetUdp)
+    ,m_udp_listen(udpPort)
+    ,m_tcp_listen(tcpPort)
 {
-    qDebug() <<"-----DEviceFinder initial-----";
+    FINDER_TRACE() <<"-----DEviceFinder initial-----";
+
+    m_listener = new DiscoveryListener(DiscoveryListener::Role::Finder, this);
+    m_listener->setPorts(m_tcp_listen, m_udp_listen);
+    connect(m_listener, &DiscoveryListener::heartbeat, this,
+            [this](const DeviceAddress &address, qint64 rttUs, quint64 deviceId, quint32 sequence) {
+        // 在线检测的应答只刷新设备表，不作为新的发现结果
+        if (sequence & LIVENESS_SEQUENCE_FLAG) {
+            m_registry->observe(address, QDateTime::currentMSecsSinceEpoch(),
+                                DiscoveryMethod::Unknown, rttUs, deviceId);
+            return;
+        }
+        reportDevice(address, DiscoveryMethod::Unknown, rttUs, deviceId);
+    });
+    connect(m_listener, &DiscoveryListener::tcpClientConnected, this, [this]() {
+        if (!m_continuous) {
+            isconnected = true;
+            m_sweepStrategy->stop();
+        }
+    });
 
-    tcpServer = new QTcpServer(this);
-    udpSocket = new QUdpSocket(this);
-    udpSocket->setSocketOption(QAbstractSocket::MulticastLoopbackOption, 1);
+    m_context = new DiscoveryContext(m_listener, m_udp_target, this);
+    m_registry = new DeviceRegistry(this);
+    m_liveness = new LivenessMonitor(m_listener, m_udp_target, this);
+    m_services = new ServiceProber(this);
+    connect(m_registry, &DeviceRegistry::deviceAdded, this, [this](const DeviceRecord &record) {
+        if (m_replaying) {
+            return;
+        }
+        if (m_livenessEnabled) {
+            m_liveness->watch(record.address);
+        }
+        m_services->enqueue(record.address);
+    });
+    connect(m_registry, &DeviceRegistry::deviceExpired, this, [this](const DeviceRecord &record) {
+        m_liveness->unwatch(record.address);
+        m_services->cancel(record.address);
+    });
+    connect(m_services, &ServiceProber::hostProbed, m_registry, &DeviceRegistry::setOpenPorts);
+
+    m_cacheStrategy = new CacheStrategy(m_context, this);
+    m_sweepStrategy = new SweepStrategy(m_context, this);
+    m_broadcastStrategy = new BroadcastStrategy(m_context, this);
+    m_mdnsStrategy = new MdnsStrategy(m_context, this);
+    m_ipv6Strategy = new Ipv6Strategy(m_context, this);
+    connect(m_cacheStrategy, &CacheStrategy::graceExpired, this, [this]() {
+        // 持续模式下需要完整设备表，总是继续完整发现
+        if ((m_continuous || !m_found) && !isconnected) {
+            FINDER_TRACE() << "Cached devices silent, starting full discovery";
+            startMethods();
+        }
+    });
 
+    m_sweepStrategy->setTarget(m_targetIp);
+    registerStrategy(m_cacheStrategy);
+    registerStrategy(m_sweepStrategy);
+    registerStrategy(m_broadcastStrategy);
+    registerStrategy(m_mdnsStrategy);
+    registerStrategy(m_ipv6Strategy);
+    updateEnabled();
+
+    // 一旦有设备应答，立即停止剩余的广播探测（持续模式除外）
+    connect(this, &DeviceFinder::deviceFound, this, [this]() {
+        if (!m_continuous) {
+            m_broadcastStrategy->stop();
+        }
+    });
 }
 
-void DeviceFinder::stopDiscovery()
+DeviceFinder::DeviceFinder(const DiscoveryProfile &profile, QObject *parent)
+    : DeviceFinder(profile.methods, profile.targets, profile.tcpPort, profile.udpPort,
+                   profile.targetUdpPort, parent)
 {
-    qDebug()<<"----Stop Discovery----" ;
-    isconnected = true;
-    // tcpServer->deleteLater();
-    // udpSocket->deleteLater();
+    setSendRate(profile.sendRate);
+    setContinuous(profile.continuous);
+}
 
+void DeviceFinder::addStrategy(DiscoveryStrategy *strategy)
+{
+    strategy->setParent(this);
+    registerStrategy(strategy);
+    m_custom.append(strategy);
+    m_enabled.append(strategy);
 }
 
+void DeviceFinder::registerStrategy(DiscoveryStrategy *strategy)
+{
+    m_strategies.append(strategy);
+    connect(strategy, &DiscoveryStrategy::deviceResolved, this, [this, strategy](const QHostAddress &address) {
+        reportDevice(address, strategy->method());
+    });
+    connect(strategy, &DiscoveryStrategy::progress, this, &DeviceFinder::scanProgress);
+}
 
+void DeviceFinder::updateEnabled()
+{
+    // 指定目标列表（主机、区间、CIDR）时只对列表内的地址做单播探测
+    const bool byTarget = !m_targetIp.trimmed().isEmpty();
+    m_enabled.clear();
+    if (byTarget || method.value(2)) {
+        m_enabled.append(m_sweepStrategy);
+    }
+    if (!byTarget && method.value(0)) {
+        m_enabled.append(m_broadcastStrategy);
+    }
+    if (!byTarget && method.value(1)) {
+        m_enabled.append(m_mdnsStrategy);
+    }
+    if (!byTarget && method.value(3)) {
+        m_enabled.append(m_ipv6Strategy);
+    }
+    m_enabled.append(m_custom);
+}
 
-void DeviceFinder::startDiscovery()
+void DeviceFinder::applyProfile(const DiscoveryProfile &profile)
 {
-    qDebug()<< "startDiscovery";
-    if (!m_targetIp.isEmpty()) {
-        qDebug() << "startUdpScan :" << m_targetIp;
-        startUdpScan(m_targetIp);
-    } else {
-        if (method[0]) {
-            startBroadcast();
-        }
-        if (method[1]){
-            startMdns();
+    const bool running = m_discoveryClock.isValid() && !isconnected;
+    setSendRate(profile.sendRate);
+    setContinuous(profile.continuous);
+
+    if (profile.targetUdpPort != m_udp_target) {
+        m_udp_target = profile.targetUdpPort;
+        m_context->setTargetPort(m_udp_target);
+        m_liveness->setTargetPort(m_udp_target);
+    }
+    if (profile.tcpPort != m_tcp_listen || profile.udpPort != m_udp_listen) {
+        m_tcp_listen = profile.tcpPort;
+        m_udp_listen = profile.udpPort;
+        m_listener->rebind(m_tcp_listen, m_udp_listen);
+    }
+
+    const bool targetsChanged = profile.targets != m_targetIp;
+    m_targetIp = profile.targets;
+    method = profile.methods;
+    if (targetsChanged) {
+        m_sweepStrategy->setTarget(m_targetIp);
+    }
+
+    const QList<DiscoveryStrategy *> before = m_enabled;
+    updateEnabled();
+    if (!running) {
+        return;
+    }
+    // 只启停有变化的策略，其余策略与设备表保持不变
+    for (DiscoveryStrategy *strategy : before) {
+        if (!m_enabled.contains(strategy)) {
+            strategy->stop();
         }
-        if (method[2]) {
-            startUdpScan("");
+    }
+    for (DiscoveryStrategy *strategy : qAsConst(m_enabled)) {
+        if (!before.contains(strategy)) {
+            strategy->start();
+        } else if (strategy == m_sweepStrategy && targetsChanged) {
+            strategy->stop();
+            strategy->start();
         }
     }
 }
 
-void DeviceFinder::startBroadcast()
+void DeviceFinder::setBroadcastBudget(int maxProbes, int maxDurationMs)
 {
-    QTimer::singleShot(0, this, [this]() {
-        broadcastCounter = 0;
-        broadcastTimer = new QTimer(this);
+    m_broadcastStrategy->scheduler()->setBudget(maxProbes, maxDurationMs);
+}
 
-        connect(broadcastTimer, &QTimer::timeout, this, [this]() {
-            if (broadcastCounter++ >= 30) {
-                broadcastTimer->stop();
-                return;
-            }
-            udpSocket->writeDatagram(MESSAGE, QHostAddress::Broadcast, m_udp_target);
-        });
+void DeviceFinder::setSendRate(int packetsPerSecond)
+{
+    m_sweepStrategy->setRate(packetsPerSecond);
+}
 
-        broadcastTimer->start(1000);
-    });
+void DeviceFinder::setSweepHints(const QVector<QPair<quint32, quint32>> &ranges)
+{
+    m_sweepStrategy->setHintRanges(ranges);
 }
 
-void  DeviceFinder::startMdns()
+void DeviceFinder::setLivenessInterval(int ms)
 {
-    qDebug()<< "Method 2 startMdns";
-    m_server = new QMdnsEngine::Server(this);
-    m_hostname = new QMdnsEngine::Hostname(m_server, this);
-    m_provider = new QMdnsEngine::Provider(m_server, m_hostname, this);
+    m_livenessEnabled = ms > 0;
+    if (!m_livenessEnabled) {
+        m_liveness->clear();
+        return;
+    }
+    m_liveness->setInterval(ms);
+    for (const DeviceRecord &record : m_registry->devices()) {
+        m_liveness->watch(record.address);
+    }
+}
 
-    const QByteArray type = SERVICE_TYPE;
-    const QByteArray name = SERVICE_NAME;
+void DeviceFinder::setServicePorts(const QVector<quint16> &ports)
+{
+    const bool wasEnabled = !m_services->ports().isEmpty();
+    m_services->setPorts(ports);
+    if (ports.isEmpty()) {
+        m_services->clear();
+        return;
+    }
+    // 开启前已发现的设备补做一次探测
+    if (!wasEnabled) {
+        for (const DeviceRecord &record : m_registry->devices()) {
+            m_services->enqueue(record.address);
+        }
+    }
+}
 
-    m_service.setType(type);
-    m_service.setName(name);
-    m_service.setPort(8080);
+void DeviceFinder::setMaxTcpClients(int maxClients)
+{
+    m_listener->setMaxTcpClients(maxClients);
+}
 
-    m_provider->update(m_service);
+void DeviceFinder::setCacheGracePeriod(int ms)
+{
+    m_cacheStrategy->setGracePeriod(ms);
 }
 
-void DeviceFinder::startUdpScan(const QString &targetIp="")
+bool DeviceFinder::setCaptureFile(const QString &path)
 {
-    qDebug() << "Method 3 startUdpScan";
-    QTimer *scanTimer = new QTimer(this);
-    connect(scanTimer, &QTimer::timeout, this, [this, targetIp, scanTimer]() {
-        if (isconnected) {
-            scanTimer->stop();
-            scanTimer->deleteLater();
-            return;
-        }
-        if (!targetIp.isEmpty()) {
-            scanTarget(targetIp);
-        }else {
-            startSubnetScan();
-        }
-    });
-    scanTimer->start(1000);
+    if (m_capture) {
+        CaptureWriter::setActive(nullptr);
+        FINDER_TRACE() << "Capture closed," << m_capture->records() << "records";
+        m_capture.reset();
+    }
+    if (path.isEmpty()) {
+        return true;
+    }
+    std::unique_ptr<CaptureWriter> capture(new CaptureWriter);
+    if (!capture->open(path)) {
+        return false;
+    }
+    m_capture = std::move(capture);
+    CaptureWriter::setActive(m_capture.get());
+    return true;
 }
-void DeviceFinder::scanTarget(const QString &ip)
+
+qint64 DeviceFinder::replayCapture(const QString &path)
 {
+    CaptureReader reader;
+    if (!reader.open(path)) {
+        return -1;
+    }
+    if (!m_discoveryClock.isValid()) {
+        m_discoveryClock.start();
+    }
+    qint64 records = 0;
+    CaptureRecord record;
+    m_replaying = true;
+    while (reader.next(&record)) {
+        ++records;
+        // 应答回显的是记录时的时钟，回放时把时钟拨到接收时刻即可重现 RTT
+        SubnetSweeper::setClockOverride(record.timestampNs / 1000);
+        switch (record.kind) {
+        case CaptureKind::DatagramReceived:
+            m_listener->replayDatagram(record.address, record.port, record.data, record.size);
+            break;
+        case CaptureKind::TcpReceived:
+            m_listener->replayTcp(record.address, record.port, record.data, record.size);
+            break;
+        case CaptureKind::ProbeSent:
+            countMetric(MetricCounter::ProbesSent);
+            break;
+        default:
+            break;
+        }
+    }
+    SubnetSweeper::setClockOverride(-1);
+    m_replaying = false;
+    m_listener->resetReplay();
+    FINDER_TRACE() << "Replayed" << records << "records from" << path;
+    return records;
+}
 
-    QHostAddress address(ip);
-    udpSocket->writeDatagram(MESSAGE, address, m_udp_target);
-    qDebug()<< "Send to " << address << "Port: " <<m_udp_target;
+void DeviceFinder::stopDiscovery()
+{
+    FINDER_TRACE()<<"----Stop Discovery----" ;
+    isconnected = true;
+    for (DiscoveryStrategy *strategy : qAsConst(m_strategies)) {
+        strategy->stop();
+    }
 }
 
-void DeviceFinder::startSubnetScan()
+
+
+void DeviceFinder::shutdown()
 {
-    qDebug()<<"startSubnetScan-----------";
-    QPair<QHostAddress, QHostAddress> ip_mask = NetworkUtils::getLocalIp();
-    QHostAddress ipAddr = ip_mask.first;
-    QHostAddress maskAddr = ip_mask.second;
+    stopDiscovery();
+    m_liveness->clear();
+    m_services->clear();
+    m_context->releaseSockets();
+    m_listener->close();
+    setCaptureFile(QString());
+}
 
-    if (ipAddr.isNull() || maskAddr.isNull()) {
-        qWarning() << "Failed to obtain valid network information";
+void DeviceFinder::startDiscovery()
+{
+    FINDER_TRACE()<< "startDiscovery";
+    m_discoveryClock.start();
+    if (m_cacheEnabled && m_targetIp.isEmpty() && m_cacheStrategy->hasCandidates()) {
+        // 与广播一样延后到事件循环，确保监听套接字先完成绑定
+        QTimer::singleShot(0, this, [this]() {
+            if (!isconnected) {
+                m_cacheStrategy->start();
+            }
+        });
         return;
     }
+    startMethods();
+}
 
-    quint32 ip = ipAddr.toIPv4Address();
-    quint32 mask = maskAddr.toIPv4Address();
-
-    quint32 network = ip & mask;
-    quint32 broadcast = network | (~mask);
-    for (quint32 addr = network + 1; addr < broadcast; ++addr) {
-        QHostAddress targetAddr(addr);
-        // 排除本机地址
-        if (targetAddr != ipAddr) {
-            scanTarget(targetAddr.toString());
-        }
+void DeviceFinder::startMethods()
+{
+    for (DiscoveryStrategy *strategy : qAsConst(m_enabled)) {
+        strategy->start();
     }
 }
 
 void DeviceFinder::startListening()
 {
-    qDebug()<< "startListening";
-    startTcpServer();
-    startUdpListener();
+    m_listener->start();
 }
 
-void DeviceFinder::startTcpServer()
+void DeviceFinder::reportDevice(const QHostAddress &address, DiscoveryMethod method,
+                                qint64 rttUs, quint64 deviceId)
 {
-    qDebug()<< "startTcpServer";
-    connect(tcpServer, &QTcpServer::newConnection, this, &DeviceFinder::handleTcpConnection);
-
-    tcpServer->listen(QHostAddress::Any, m_tcp_listen);
+    const DeviceAddress device = DeviceAddress::fromHostAddress(address);
+    if (!device.isNull()) {
+        reportDevice(device, method, rttUs, deviceId);
+    }
 }
 
-void DeviceFinder::startUdpListener()
+void DeviceFinder::reportDevice(const DeviceAddress &device, DiscoveryMethod method,
+                                qint64 rttUs, quint64 deviceId)
 {
-    qDebug() << "startUdpListener";
-    udpSocket->bind(m_udp_listen);
+    m_found = true;
 
-    connect(udpSocket, &QUdpSocket::readyRead, this, [this]() {
-        while(udpSocket->hasPendingDatagrams()) {
-            QByteArray datagram;
-            datagram.resize(udpSocket->pendingDatagramSize());
+    qint64 sentAt = -1;
+    const DiscoveryMethod probedBy = attributeMethod(device, &sentAt);
+    if (method == DiscoveryMethod::Unknown) {
+        method = probedBy;
+    }
+    if (rttUs < 0 && sentAt >= 0) {
+        rttUs = SubnetSweeper::clockUs() - sentAt;
+    }
+    DiscoveryMetrics &metrics = DiscoveryMetrics::instance();
+    metrics.recordRtt(rttUs);
+    const bool added = m_registry->observe(device, QDateTime::currentMSecsSinceEpoch(),
+                                           method, rttUs, deviceId);
+    if (added) {
+        metrics.add(MetricCounter::DevicesFound);
+        metrics.recordDiscovery(method, m_discoveryClock.nsecsElapsed() / 1000);
+    }
+    // 持续模式下重复心跳只更新设备表
+    if (m_continuous && !added) {
+        return;
+    }
 
-            QHostAddress sender;
-            quint16 senderPort;
-            udpSocket->readDatagram(datagram.data(), datagram.size(), &sender, &senderPort);
-            qDebug() << "Udp client ip: " << sender << " port: " <<senderPort;
-            qDebug() << "Udp received :" << datagram.data();
-            if (datagram == HEARTBEAT) {
-                udpSocket->writeDatagram(EXIT_MESSAGE, sender, senderPort);
-                emit DeviceFinder::deviceFound(sender.toString());
-            }
-        }
-    });
+    const QHostAddress address = device.toHostAddress();
+    // 缓存文件只保存 IPv4 设备
+    if (m_cacheEnabled && device.isIpv4()) {
+        m_cacheStrategy->record(address, method);
+    }
+    emit deviceFound(address.toString());
 }
 
-void DeviceFinder::handleTcpConnection()
-{
-    QTcpSocket *client = tcpServer->nextPendingConnection();
-    qDebug() << "Tcp connection";
-    isconnected=true;
-    QTimer *heartbeatTimer = new QTimer(client);
-    connect(client, &QTcpSocket::readyRead, [&, client, heartbeatTimer]() {
-        heartbeatTimer->start(60000);
-        QHostAddress clientAddr = QHostAddress(client->peerAddress().toIPv4Address());
-        qDebug()<<"client ip: " <<clientAddr << " port: " << client->peerPort();
-        QByteArray data = client->readAll();
-        qDebug() << "TCP recevied message: " << data;
-        if (data == HEARTBEAT) {
-            client->write(EXIT_MESSAGE);
-            emit DeviceFinder::deviceFound(client->peerAddress().toString());
+DiscoveryMethod DeviceFinder::attributeMethod(const DeviceAddress &device, qint64 *sentAtUs) const
+{
+    // 应答本身不携带方式，归因于最近一次探测过该地址的策略
+    DiscoveryMethod method = DiscoveryMethod::Unknown;
+    *sentAtUs = -1;
+    for (const DiscoveryStrategy *strategy : m_strategies) {
+        const qint64 sentAt = strategy->probeSentAt(device);
+        if (sentAt > *sentAtUs) {
+            *sentAtUs = sentAt;
+            method = strategy->method();
         }
+    }
+    return method;
+}
 
-    });
 
-    connect(heartbeatTimer, &QTimer::timeout, [client]() {
-        client->close();
+// ****-------------------------------------------------****
+ServerShard::ServerShard(quint16 tcpPort, quint16 udpPort, quint64 deviceId, int sessionIdleMs)
+    : m_sessions(4096)
+    , m_tcpPort(tcpPort)
+    , m_udpPort(udpPort)
+    , m_deviceId(deviceId)
+    , m_sessionIdleMs(sessionIdleMs)
+{
+}
+
+void ServerShard::start()
+{
+    // 在分片线程中创建，套接字与通知器都归属该线程
+    m_listener = new DiscoveryListener(DiscoveryListener::Role::Device, this);
+    m_listener->setPorts(m_tcpPort, m_udpPort);
+    m_listener->setDeviceId(m_deviceId);
+    m_listener->setReusePort(true);
+    m_listener->setBatchReplies(true);
+    m_listener->setSessions(&m_sessions);
+    connect(m_listener, &DiscoveryListener::messageReceived, this, [this]() {
+        m_sessionCount.store(m_sessions.size(), std::memory_order_relaxed);
+        emit peerAdded();
     });
+    m_listener->start();
+
+    QTimer *expiryTimer = new QTimer(this);
+    connect(expiryTimer, &QTimer::timeout, this, &ServerShard::expireSessions);
+    expiryTimer->start(qMax(250, m_sessionIdleMs / 4));
 }
 
+void ServerShard::expireSessions()
+{
+    const qint64 cutoff = SubnetSweeper::clockUs() - qint64(m_sessionIdleMs) * 1000;
+    m_sessions.expire(cutoff, [this](const PeerSession &session) {
+        emit peerExpired(session.address);
+    });
+    m_sessionCount.store(m_sessions.size(), std::memory_order_relaxed);
+}
 
-// ****-------------------------------------------------****
 ConnectionHandler::ConnectionHandler(QObject *parent)
     :QObject(parent)
 {
-    tcpServer = new QTcpServer(this);
-    udpSocket = new QUdpSocket(this);
+    qRegisterMetaType<DeviceAddress>("DeviceAddress");
+    m_listener = new DiscoveryListener(DiscoveryListener::Role::Device, this);
+    connect(m_listener, &DiscoveryListener::messageReceived, this, &ConnectionHandler::connectionSuccess);
 }
 
-void ConnectionHandler::startListening()
+ConnectionHandler::~ConnectionHandler()
 {
-    qDebug()<< "startListening";
-    startTcpServer();
-    startUdpListener();
+    // 先结束网络线程，监听在该线程内释放后才销毁本对象
+    delete m_network;
+    for (QThread *thread : qAsConst(m_threads)) {
+        thread->quit();
+    }
+    for (QThread *thread : qAsConst(m_threads)) {
+        thread->wait();
+    }
 }
 
-void ConnectionHandler::startTcpServer()
+void ConnectionHandler::setDeviceId(quint64 id)
 {
-    qDebug()<< "startTcpServer";
-    connect(tcpServer, &QTcpServer::newConnection, this, &ConnectionHandler::handleTcpConnection);
-
-    tcpServer->listen(QHostAddress::Any, m_tcp_listen);
+    m_deviceId = id;
+    // 监听已移入网络线程时以队列调用交给它
+    DiscoveryListener *listener = m_listener;
+    QMetaObject::invokeMethod(listener, [listener, id]() { listener->setDeviceId(id); });
 }
 
-void ConnectionHandler::startUdpListener()
+void ConnectionHandler::setPorts(quint16 tcpPort, quint16 udpPort)
 {
-    qDebug() << "startUdpListener";
-    udpSocket->bind(m_udp_listen);
-
-    connect(udpSocket, &QUdpSocket::readyRead, this, [this]() {
-        while(udpSocket->hasPendingDatagrams()) {
-            QByteArray datagram;
-            datagram.resize(udpSocket->pendingDatagramSize());
-
-            QHostAddress sender;
-            quint16 senderPort;
-            udpSocket->readDatagram(datagram.data(), datagram.size(), &sender, &senderPort);
-            qDebug() << "Udp client ip: " << sender << " port: " <<senderPort;
-            qDebug() << "Udp received :" << datagram.data();
-            emit connectionSuccess();
-            if (datagram == "heartbeat") {
-                udpSocket->writeDatagram("heartbeat", sender, senderPort);
-            }
-        }
+    m_tcp_listen = tcpPort;
+    m_udp_listen = udpPort;
+    DiscoveryListener *listener = m_listener;
+    QMetaObject::invokeMethod(listener, [listener, tcpPort, udpPort]() {
+        listener->setPorts(tcpPort, udpPort);
     });
 }
 
-void ConnectionHandler::handleTcpConnection()
+int ConnectionHandler::sessionCount() const
 {
-    QTcpSocket *client = tcpServer->nextPendingConnection();
-    qDebug() << "Tcp connection";
-    QTimer *heartbeatTimer = new QTimer(client);
-    emit connectionSuccess();
-    connect(client, &QTcpSocket::readyRead, [client, heartbeatTimer]() {
-        heartbeatTimer->start(60000);
-        qDebug()<<"client ip: " <<client->peerAddress() << " port: " << client->peerPort();
-        QByteArray data = client->readAll();
-        qDebug() << "TCP recevied message: " << data;
-        client->write("heartbeat");
-
-    });
-
-    connect(heartbeatTimer, &QTimer::timeout, [client]() {
-        client->close();
-    });
+    int count = 0;
+    for (const ServerShard *shard : m_shards) {
+        count += shard->sessionCount();
+    }
+    return count;
 }
 
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
+void ConnectionHandler::startListening()
+{
+    if (m_serverThreads == 0) {
+        if (m_network) {
+            return;
+        }
+        // 收包与应答在独立的网络线程中进行，不占用调用方（通常是界面）线程
+        m_network = new NetworkWorker;
+        m_listener->setParent(nullptr);
+        m_network->adopt(m_listener);
+        DiscoveryListener *listener = m_listener;
+        QMetaObject::invokeMethod(listener, [listener]() { listener->start(); }, Qt::QueuedConnection);
+        return;
+    }
+    if (!m_shards.isEmpty()) {
+        return;
+    }
+    for (int i = 0; i < m_serverThreads; ++i) {
+        QThread *thread = new QThread(this);
+        thread->setObjectName(QStringLiteral("HeartbeatShard%1").arg(i));
+        ServerShard *shard = new ServerShard(m_tcp_listen, m_udp_listen, m_deviceId, m_sessionIdleMs);
+        shard->moveToThread(thread);
+        connect(thread, &QThread::finished, shard, &QObject::deleteLater);
+        connect(shard, &ServerShard::peerAdded, this, &ConnectionHandler::connectionSuccess);
+        connect(shard, &ServerShard::peerExpired, this, &ConnectionHandler::peerExpired);
+        thread->start();
+        QMetaObject::invokeMethod(shard, "start", Qt::QueuedConnection);
+        m_shards.append(shard);
+        m_threads.append(thread);
+    }
+    FINDER_TRACE() << "Heartbeat server on" << m_udp_listen << "/" << m_tcp_listen
+                   << "with" << m_serverThreads << "threads";
+}
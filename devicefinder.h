@@ -1,76 +1,33 @@
 #ifndef DEVICEFINDER_H
 #define DEVICEFINDER_H
 
-#include <QTcpServer>
 #include <QCoreApplication>
-#include <QCommandLineParser>
-#include <QNetworkInterface>
-#include <QUdpSocket>
-#include <QTcpServer>
-#include <QTcpSocket>
-#include <QThread>
+#include <QHostAddress>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QByteArray>
-#include <QPair>
-
-#include <qmdnsengine/server.h>
-#include <qmdnsengine/provider.h>
-#include <qmdnsengine/hostname.h>
-#include <qmdnsengine/service.h>
-
-constexpr quint16 UDP_TARGET_PORT = 9910;
-constexpr quint16 UDP_LISTEN_PORT = 68;
-constexpr quint16 TCP_LISTEN_PORT = 80;
-const QByteArray MESSAGE = "Hello, Device! From Finder!";
-const QByteArray SERVICE_TYPE = "_test._tcp.local.";
-const QByteArray SERVICE_NAME = "JumpWDevice";
-const QByteArray EXIT_MESSAGE = "EXIT";
-const QByteArray HEARTBEAT = "heartbeat";
-
-class NetworkUtils {
-public:
-    static QPair<QHostAddress,QHostAddress> getLocalIp() {
-        foreach (const QNetworkInterface &interface, QNetworkInterface::allInterfaces()) {
-            // 跳过未启用或未运行的接口
-            if (!interface.flags().testFlag(QNetworkInterface::IsUp) ||
-                !interface.flags().testFlag(QNetworkInterface::IsRunning)) {
-                continue;
-            }
-
-            // 检查接口类型：有线或无线
-            bool isWired = (interface.type() == QNetworkInterface::Ethernet);
-            bool isWireless = (interface.type() == QNetworkInterface::Ieee80211);
-            if (!isWired && !isWireless) {
-                continue;
-            }
-
-            // 排除名称包含虚拟设备或蓝牙的接口
-            QString ifaceName = interface.humanReadableName();
-            if (ifaceName.contains("VMware", Qt::CaseInsensitive) ||
-                ifaceName.contains("Bluetooth", Qt::CaseInsensitive)) {
-                continue;
-            }
-            foreach (const QNetworkAddressEntry &entry, interface.addressEntries()) {
-                if (!entry.ip().isLoopback() && entry.ip().protocol() == QAbstractSocket::IPv4Protocol) {
-                    return QPair<QHostAddress, QHostAddress>{entry.ip(), entry.netmask()};
-                }
-            }
-        }
-        return QPair<QHostAddress, QHostAddress>{QHostAddress::LocalHost, QHostAddress::LocalHost};
-    }
-
-    static QList<QNetworkInterface> getValidInterfaces() {
-        QList<QNetworkInterface> validInterfaces;
-        foreach (const QNetworkInterface &interface, QNetworkInterface::allInterfaces()) {
-            if (interface.flags() & QNetworkInterface::IsUp &&
-                !(interface.flags() & QNetworkInterface::IsLoopBack)) {
-                    validInterfaces.append(interface);
-                }
-        }
-        return validInterfaces;
-    }
-};
+#include <QList>
+#include <QVector>
+#include <QThread>
 
+#include <atomic>
+#include <memory>
+
+#include "networkutils.h"
+#include "devicecache.h"
+#include "deviceregistry.h"
+#include "discoveryprotocol.h"
+#include "discoverylistener.h"
+#include "discoverystrategy.h"
+#include "discoverystrategies.h"
+#include "livenessmonitor.h"
+#include "serviceprober.h"
+#include "sessiontable.h"
+#include "discoveryprofile.h"
+#include "discoverycapture.h"
+
+// 发现流程编排：共享监听接收应答，各发现策略并行探测，结果汇入同一设备表。
+// 有缓存时先单播探测缓存地址，宽限期内无应答再启动其余策略
 class DeviceFinder : public QObject {
     Q_OBJECT
 
@@ -81,9 +38,68 @@ public :
                           const quint16 udpPort,
                           const quint16 targetUdp,
                           QObject* parent=nullptr);
+    explicit DeviceFinder(const DiscoveryProfile &profile, QObject *parent = nullptr);
 
     void startDiscovery();
 
+    // 运行中切换配置：速率、目标、发现方式与目标端口即时生效，监听端口变化时重新绑定；
+    // 只启停有变化的策略，设备表与在线检测保持不变
+    void applyProfile(const DiscoveryProfile &profile);
+
+    // 子网扫描的每秒探测包预算
+    void setSendRate(int packetsPerSecond);
+
+    // 扫描时优先探测的地址区间（如 DHCP 地址池），排在 ARP 表中的主机之后
+    void setSweepHints(const QVector<QPair<quint32, quint32>> &ranges);
+
+    // 同时保持的 TCP 客户端上限
+    void setMaxTcpClients(int maxClients);
+
+    // 广播探测的总预算：最多次数与最长持续时间
+    void setBroadcastBudget(int maxProbes, int maxDurationMs);
+
+    // 缓存地址单播探测后等待应答的时间，超时才开始完整扫描
+    void setCacheGracePeriod(int ms);
+
+    // 关闭后不读写设备缓存，直接启动各发现策略（基准测试等场景）
+    void setCacheEnabled(bool enabled) { m_cacheEnabled = enabled; }
+
+    // 持续发现：找到设备后不停止，持续维护设备表
+    void setContinuous(bool continuous) { m_continuous = continuous; }
+    bool isContinuous() const { return m_continuous; }
+
+    DeviceRegistry *registry() const { return m_registry; }
+
+    // 对设备表中的设备做在线检测，ms 为每台设备的心跳间隔，0 关闭
+    void setLivenessInterval(int ms);
+    LivenessMonitor *liveness() const { return m_liveness; }
+
+    // 对新发现的设备探测这些 TCP 端口，结果写入设备记录的 openPorts；空列表关闭
+    void setServicePorts(const QVector<quint16> &ports);
+    ServiceProber *services() const { return m_services; }
+
+    // 自定义策略与内置策略并行运行；应在 startDiscovery() 之前添加，
+    // 策略的 parent 会被设为 DeviceFinder
+    void addStrategy(DiscoveryStrategy *strategy);
+
+    // 自定义策略用于发送探测的共享资源
+    DiscoveryContext *context() const { return m_context; }
+
+    // 把发出的探测与收到的数据报、TCP 数据追加到抓包文件，空路径停止记录
+    bool setCaptureFile(const QString &path);
+
+    // 离线回放抓包：不收发网络数据，按记录时刻驱动 clockUs() 并把接收记录
+    // 送入监听与设备表，不限速运行；回放中发现的设备不加入在线检测与服务探测。
+    // 返回回放的记录数，文件无效时返回 -1。
+    // 不应与实时发现同时使用
+    qint64 replayCapture(const QString &path);
+
+    // 立即停止发现并释放全部网络资源：各策略（含 mDNS 对象）、在线检测、服务探测、
+    // 网卡套接字、监听端口与抓包文件。设备表保留，之后只应释放 finder
+    void shutdown();
+
+    bool isListening() const { return m_listener->isListening(); }
+
 public slots:
     void stopDiscovery();
 
@@ -92,40 +108,54 @@ public slots:
 signals:
     void deviceFound(QString ip);
 
-private:
-    void startBroadcast();
-
-    void  startMdns();
-
-    void startUdpScan(const QString &targetIp );
+    void scanProgress(quint64 sent, quint64 total);
 
-    void scanTarget(const QString &ip);
-
-    void startSubnetScan();
+private:
+    void registerStrategy(DiscoveryStrategy *strategy);
 
-    // Listening
-    void startTcpServer();
+    // 按 method 与目标列表重新计算 m_enabled
+    void updateEnabled();
 
-    void handleTcpConnection();
+    void startMethods();
 
-    void startUdpListener();
+    // method 为 Unknown 时按各策略的探测记录归类
+    void reportDevice(const QHostAddress &address,
+                      DiscoveryMethod method = DiscoveryMethod::Unknown,
+                      qint64 rttUs = -1, quint64 deviceId = 0);
+    void reportDevice(const DeviceAddress &device, DiscoveryMethod method = DiscoveryMethod::Unknown,
+                      qint64 rttUs = -1, quint64 deviceId = 0);
 
+    // 找出最近探测过该地址的策略，sentAtUs 为其发送时刻
+    DiscoveryMethod attributeMethod(const DeviceAddress &device, qint64 *sentAtUs) const;
 
-    QMdnsEngine::Server *m_server;
-    QMdnsEngine::Hostname *m_hostname;
-    QMdnsEngine::Provider *m_provider;
-    QMdnsEngine::Service m_service;
 
-    QTcpServer *tcpServer;
+    DiscoveryListener *m_listener;
+    DiscoveryContext *m_context;
 
+    // 按归类优先级排列：缓存、扫描、广播、mDNS、IPv6、自定义
+    QList<DiscoveryStrategy *> m_strategies;
+    QList<DiscoveryStrategy *> m_enabled;
+    QList<DiscoveryStrategy *> m_custom;
+    CacheStrategy *m_cacheStrategy;
+    SweepStrategy *m_sweepStrategy;
+    BroadcastStrategy *m_broadcastStrategy;
+    MdnsStrategy *m_mdnsStrategy;
+    Ipv6Strategy *m_ipv6Strategy;
 
     QVector<bool> method;
     QString m_targetIp;
-    // mdnsService
-    QUdpSocket *udpSocket;
-    QTimer *broadcastTimer;
-    int broadcastCounter = 0;
-    int currentMethod = 3;
+    bool m_found = false;
+    QElapsedTimer m_discoveryClock;     // 发现开始时刻，用于按方式统计发现耗时
+    bool m_cacheEnabled = true;
+
+    DeviceRegistry *m_registry;
+    LivenessMonitor *m_liveness;
+    bool m_livenessEnabled = false;
+    bool m_replaying = false;   // 回放期间不做在线检测与服务探测，不产生网络流量
+    ServiceProber *m_services;
+    bool m_continuous = false;
+
+    std::unique_ptr<CaptureWriter> m_capture;
 
     quint16 m_udp_target = UDP_TARGET_PORT;
     quint16 m_udp_listen = UDP_LISTEN_PORT;
@@ -134,34 +164,78 @@ private:
     bool isconnected = false;
 };
 
-class ConnectionHandler : public QObject {
+// 服务端模式的一个分片：在自己的线程中运行一个 SO_REUSEPORT 监听和一张会话表，
+// 与其它分片不共享任何状态
+class ServerShard : public QObject {
     Q_OBJECT
 public:
-    explicit ConnectionHandler(QObject *parent = nullptr);
+    ServerShard(quint16 tcpPort, quint16 udpPort, quint64 deviceId, int sessionIdleMs);
+
+    int sessionCount() const { return m_sessionCount.load(std::memory_order_relaxed); }
 
 public slots:
-    void startListening();
+    void start();
 
 signals:
-    // 成功连接信号
-    void connectionSuccess();
+    void peerAdded();
+    void peerExpired(const DeviceAddress &address);
 
 private:
-     void startTcpServer();
+    void expireSessions();
+
+    DiscoveryListener *m_listener = nullptr;
+    SessionTable m_sessions;
+    quint16 m_tcpPort;
+    quint16 m_udpPort;
+    quint64 m_deviceId;
+    int m_sessionIdleMs;
+    std::atomic<int> m_sessionCount{0};
+};
 
-    void handleTcpConnection();
+class NetworkWorker;
 
-    void startUdpListener();
+class ConnectionHandler : public QObject {
+    Q_OBJECT
+public:
+    explicit ConnectionHandler(QObject *parent = nullptr);
+    ~ConnectionHandler() override;
 
+    // 心跳帧中上报的设备 ID
+    void setDeviceId(quint64 id);
 
-    QTcpServer *tcpServer;
-    QUdpSocket *udpSocket;
+    void setPorts(quint16 tcpPort, quint16 udpPort);
 
-    quint16 m_udp_target = UDP_TARGET_PORT;
-    quint16 m_udp_listen = UDP_LISTEN_PORT;
-    quint16 m_tcp_listen = TCP_LISTEN_PORT;
+    // 服务端模式：threads 个线程各自以 SO_REUSEPORT 绑定同一 UDP / TCP 端口，
+    // 内核按对端分流；每个线程维护自己的会话表并批量应答，connectionSuccess
+    // 只在新对端出现时发出。0 为原来的单线程模式。须在 startListening() 之前设置
+    void setServerThreads(int threads) { m_serverThreads = qMax(0, threads); }
+    // 服务端模式下对端超过该时间无消息即结束会话
+    void setSessionIdleTimeout(int ms) { m_sessionIdleMs = qMax(1000, ms); }
+
+    // 服务端模式下各分片的会话总数
+    int sessionCount() const;
 
+public slots:
+    void startListening();
+
+signals:
+    // 成功连接信号
+    void connectionSuccess();
+
+    // 服务端模式：会话超时结束
+    void peerExpired(const DeviceAddress &address);
+
+private:
+    DiscoveryListener *m_listener;
+    NetworkWorker *m_network = nullptr;     // 单线程模式下运行监听的网络线程
+    quint64 m_deviceId = 0;
+    quint16 m_tcp_listen = TCP_LISTEN_PORT;
+    quint16 m_udp_listen = UDP_LISTEN_PORT;
 
+    int m_serverThreads = 0;
+    int m_sessionIdleMs = 60000;
+    QList<ServerShard *> m_shards;
+    QList<QThread *> m_threads;
 };
 
 
@@ -0,0 +1,153 @@
+#include "deviceregistry.h"
+
+#include <QDateTime>
+
+DeviceRegistry::DeviceRegistry(QObject *parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<DeviceRecord>("DeviceRecord");
+    qRegisterMetaType<QVector<DeviceRecord>>("QVector<DeviceRecord>");
+    qRegisterMetaType<QVector<DeviceAddress>>("QVector<DeviceAddress>");
+
+    m_expiryTimer = new QTimer(this);
+    connect(m_expiryTimer, &QTimer::timeout, this, [this]() {
+        expire(QDateTime::currentMSecsSinceEpoch());
+    });
+    setExpiry(m_expiryMs);
+}
+
+void DeviceRegistry::setExpiry(int expiryMs)
+{
+    m_expiryMs = qMax(1000, expiryMs);
+    m_expiryTimer->start(qMax(250, m_expiryMs / 4));
+}
+
+void DeviceRegistry::setBatchInterval(int ms)
+{
+    if (ms <= 0) {
+        delete m_batchTimer;
+        m_batchTimer = nullptr;
+        m_changed.clear();
+        m_removed.clear();
+        return;
+    }
+    if (!m_batchTimer) {
+        m_batchTimer = new QTimer(this);
+        m_batchTimer->setSingleShot(true);
+        connect(m_batchTimer, &QTimer::timeout, this, &DeviceRegistry::flushBatch);
+    }
+    m_batchTimer->setInterval(ms);
+}
+
+void DeviceRegistry::markChanged(const DeviceAddress &address)
+{
+    if (!m_batchTimer) {
+        return;
+    }
+    m_changed.insert(address);
+    if (!m_batchTimer->isActive()) {
+        m_batchTimer->start();
+    }
+}
+
+void DeviceRegistry::flushBatch()
+{
+    if (m_batchTimer) {
+        m_batchTimer->stop();
+    }
+    QVector<DeviceRecord> changed;
+    changed.reserve(m_changed.size());
+    for (const DeviceAddress &address : qAsConst(m_changed)) {
+        // 周期内已过期的设备只出现在 removed 中
+        auto it = m_devices.constFind(address);
+        if (it != m_devices.constEnd()) {
+            changed.append(it->record);
+        }
+    }
+    QVector<DeviceAddress> removed;
+    removed.swap(m_removed);
+    m_changed.clear();
+    if (!changed.isEmpty() || !removed.isEmpty()) {
+        emit devicesChanged(changed, removed);
+    }
+}
+
+bool DeviceRegistry::observe(const DeviceAddress &address, qint64 nowMs, DiscoveryMethod method,
+                             qint64 rttUs, quint64 deviceId)
+{
+    auto it = m_devices.find(address);
+    if (it == m_devices.end()) {
+        Entry entry;
+        entry.record.address = address;
+        entry.record.ipv4 = address.toIpv4();
+        entry.record.method = method;
+        entry.record.firstSeen = nowMs;
+        entry.record.lastSeen = nowMs;
+        entry.record.rttUs = rttUs;
+        entry.record.heartbeats = 1;
+        entry.record.deviceId = deviceId;
+        entry.lastNotified = nowMs;
+        it = m_devices.insert(address, entry);
+        markChanged(address);
+        emit deviceAdded(it->record);
+        return true;
+    }
+
+    DeviceRecord &record = it->record;
+    record.lastSeen = nowMs;
+    ++record.heartbeats;
+    if (rttUs >= 0) {
+        record.rttUs = rttUs;
+    }
+    if (deviceId != 0) {
+        record.deviceId = deviceId;
+    }
+    if (nowMs - it->lastNotified >= m_updateIntervalMs) {
+        it->lastNotified = nowMs;
+        markChanged(address);
+        emit deviceUpdated(record);
+    }
+    return false;
+}
+
+bool DeviceRegistry::setOpenPorts(const DeviceAddress &address, const QVector<quint16> &ports)
+{
+    auto it = m_devices.find(address);
+    if (it == m_devices.end()) {
+        return false;
+    }
+    it->record.openPorts = ports;
+    markChanged(address);
+    emit deviceUpdated(it->record);
+    return true;
+}
+
+const DeviceRecord *DeviceRegistry::find(const DeviceAddress &address) const
+{
+    auto it = m_devices.constFind(address);
+    return it == m_devices.constEnd() ? nullptr : &it->record;
+}
+
+void DeviceRegistry::expire(qint64 nowMs)
+{
+    for (auto it = m_devices.begin(); it != m_devices.end();) {
+        if (nowMs - it->record.lastSeen > m_expiryMs) {
+            const DeviceRecord record = it->record;
+            it = m_devices.erase(it);
+            if (m_batchTimer) {
+                m_removed.append(record.address);
+                if (!m_batchTimer->isActive()) {
+                    m_batchTimer->start();
+                }
+            }
+            emit deviceExpired(record);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void DeviceRegistry::clear()
+{
+    m_devices.clear();
+}
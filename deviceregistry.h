@@ -0,0 +1,107 @@
+#ifndef DEVICEREGISTRY_H
+#define DEVICEREGISTRY_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QVector>
+#include <QTimer>
+#include <QMetaType>
+#include <QString>
+
+#include "devicecache.h"
+#include "deviceaddress.h"
+
+struct DeviceRecord {
+    DeviceAddress address;
+    quint32 ipv4 = 0;       // IPv6 设备为 0
+    DiscoveryMethod method = DiscoveryMethod::Unknown;
+    qint64 firstSeen = 0;   // ms since epoch
+    qint64 lastSeen = 0;
+    qint64 rttUs = -1;      // 最近一次测得的往返时延，未知为 -1
+    quint32 heartbeats = 0;
+    quint64 deviceId = 0;   // 帧协议中设备上报的 ID，旧协议为 0
+    QVector<quint16> openPorts;     // 服务探测发现的开放 TCP 端口，升序
+};
+Q_DECLARE_METATYPE(DeviceRecord)
+
+// 设备 ID 的统一文本格式（结果表、导出、命令行输出）：0x 前缀的十六进制，旧协议设备（0）为空
+inline QString deviceIdText(quint64 deviceId)
+{
+    return deviceId == 0 ? QString() : QStringLiteral("0x") + QString::number(deviceId, 16);
+}
+
+// 持续发现模式下的设备表，以设备地址（IPv4 或 IPv6）为键。
+// 重复心跳只做 O(1) 的哈希更新；更新事件按设备限频，过期检查由定时器批量完成
+class DeviceRegistry : public QObject {
+    Q_OBJECT
+
+public:
+    explicit DeviceRegistry(QObject *parent = nullptr);
+
+    // 超过 expiryMs 未出现的设备视为离线
+    void setExpiry(int expiryMs);
+    // 同一设备两次 deviceUpdated 的最小间隔
+    void setUpdateInterval(int ms) { m_updateIntervalMs = ms; }
+
+    // 开启后把 ms 内的新增、更新与过期合并为一次 devicesChanged，
+    // 供跨线程的界面一次处理一批而不是每台设备一个队列事件；0 关闭
+    void setBatchInterval(int ms);
+    // 立即发出尚未到期的一批变化；释放设备表前调用，否则最后一批会丢失
+    void flushBatch();
+
+    // 返回 true 表示新设备
+    bool observe(const DeviceAddress &address, qint64 nowMs, DiscoveryMethod method,
+                 qint64 rttUs = -1, quint64 deviceId = 0);
+    bool observe(quint32 ipv4, qint64 nowMs, DiscoveryMethod method,
+                 qint64 rttUs = -1, quint64 deviceId = 0) {
+        return observe(DeviceAddress::fromIpv4(ipv4), nowMs, method, rttUs, deviceId);
+    }
+
+    // 记录服务探测结果并立即发出 deviceUpdated；设备不在表中时返回 false
+    bool setOpenPorts(const DeviceAddress &address, const QVector<quint16> &ports);
+
+    const DeviceRecord *find(const DeviceAddress &address) const;
+    const DeviceRecord *find(quint32 ipv4) const { return find(DeviceAddress::fromIpv4(ipv4)); }
+    int size() const { return m_devices.size(); }
+    QList<DeviceRecord> devices() const { return m_devices.values(); }
+
+    // 逐条访问设备记录而不复制整张表（导出等场景）；回调中不得修改设备表
+    template <typename Callback>
+    void forEach(Callback visit) const {
+        for (auto it = m_devices.cbegin(); it != m_devices.cend(); ++it) {
+            visit(it->record);
+        }
+    }
+
+    void expire(qint64 nowMs);
+    void clear();
+
+signals:
+    void deviceAdded(const DeviceRecord &record);
+    void deviceUpdated(const DeviceRecord &record);
+    void deviceExpired(const DeviceRecord &record);
+
+    // setBatchInterval() 开启时：一个周期内新增或更新的记录（每台设备一条最新值）与过期的地址
+    void devicesChanged(const QVector<DeviceRecord> &changed, const QVector<DeviceAddress> &removed);
+
+private:
+    struct Entry {
+        DeviceRecord record;
+        qint64 lastNotified = 0;
+    };
+
+    // 记录待合并通知的变化
+    void markChanged(const DeviceAddress &address);
+
+    QHash<DeviceAddress, Entry> m_devices;
+    QTimer *m_expiryTimer;
+    QTimer *m_batchTimer = nullptr;
+    QSet<DeviceAddress> m_changed;
+    QVector<DeviceAddress> m_removed;
+    int m_expiryMs = 60000;
+    int m_updateIntervalMs = 1000;
+};
+
+#endif // DEVICEREGISTRY_H
@@ -0,0 +1,171 @@
+#include "devicetablemodel.h"
+
+#include <QDateTime>
+
+#include <algorithm>
+#include <functional>
+
+DeviceTableModel::DeviceTableModel(QObject *parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+int DeviceTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rows.size();
+}
+
+int DeviceTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant DeviceTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_rows.size()
+        || (role != Qt::DisplayRole && role != SortRole)) {
+        return QVariant();
+    }
+    const DeviceRecord &record = m_rows.at(index.row());
+    const bool display = role == Qt::DisplayRole;
+    switch (index.column()) {
+    case AddressColumn:
+        if (display) {
+            return record.address.toHostAddress().toString();
+        }
+        // IPv4 映射地址按数值排在 IPv6 之前
+        return QStringLiteral("%1%2").arg(record.address.hi, 16, 16, QLatin1Char('0'))
+                                     .arg(record.address.lo, 16, 16, QLatin1Char('0'));
+    case MethodColumn:
+        return QLatin1String(discoveryMethodName(record.method));
+    case RttColumn:
+        if (record.rttUs < 0) {
+            return display ? QVariant() : QVariant(qint64(-1));
+        }
+        return display ? QVariant(QString::number(record.rttUs / 1000.0, 'f', 2)) : QVariant(record.rttUs);
+    case DeviceIdColumn:
+        if (record.deviceId == 0) {
+            return display ? QVariant() : QVariant(quint64(0));
+        }
+        return display ? QVariant(deviceIdText(record.deviceId)) : QVariant(record.deviceId);
+    case OpenPortsColumn: {
+        if (!display) {
+            return record.openPorts.size();
+        }
+        QStringList ports;
+        for (quint16 port : record.openPorts) {
+            ports.append(QString::number(port));
+        }
+        return ports.join(QLatin1Char(' '));
+    }
+    case FirstSeenColumn:
+        return display ? QVariant(QDateTime::fromMSecsSinceEpoch(record.firstSeen).toString(Qt::ISODate))
+                       : QVariant(record.firstSeen);
+    case LastSeenColumn:
+        return display ? QVariant(QDateTime::fromMSecsSinceEpoch(record.lastSeen).toString(Qt::ISODate))
+                       : QVariant(record.lastSeen);
+    case HeartbeatsColumn:
+        return record.heartbeats;
+    default:
+        return QVariant();
+    }
+}
+
+QVariant DeviceTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+    switch (section) {
+    case AddressColumn: return tr("Address");
+    case MethodColumn: return tr("Method");
+    case RttColumn: return tr("RTT (ms)");
+    case DeviceIdColumn: return tr("Device ID");
+    case OpenPortsColumn: return tr("Open Ports");
+    case FirstSeenColumn: return tr("First Seen");
+    case LastSeenColumn: return tr("Last Seen");
+    case HeartbeatsColumn: return tr("Heartbeats");
+    default: return QVariant();
+    }
+}
+
+void DeviceTableModel::applyChanges(const QVector<DeviceRecord> &changed, const QVector<DeviceAddress> &removed)
+{
+    removeAddresses(removed);
+
+    QVector<int> updated;
+    QVector<DeviceRecord> added;
+    for (const DeviceRecord &record : changed) {
+        auto it = m_index.constFind(record.address);
+        if (it == m_index.constEnd()) {
+            added.append(record);
+            continue;
+        }
+        m_rows[*it] = record;
+        updated.append(*it);
+    }
+    // 按连续行区间通知；行以地址为键，地址列（排序键）不会变化，不在通知范围内，
+    // 按地址排序时代理不必因此重新排序
+    std::sort(updated.begin(), updated.end());
+    updated.erase(std::unique(updated.begin(), updated.end()), updated.end());
+    for (int i = 0; i < updated.size();) {
+        const int first = updated.at(i);
+        int last = first;
+        while (++i < updated.size() && updated.at(i) == last + 1) {
+            last = updated.at(i);
+        }
+        emit dataChanged(index(first, MethodColumn), index(last, HeartbeatsColumn));
+    }
+    if (!added.isEmpty()) {
+        const int first = m_rows.size();
+        beginInsertRows(QModelIndex(), first, first + added.size() - 1);
+        m_rows.reserve(first + added.size());
+        for (const DeviceRecord &record : qAsConst(added)) {
+            m_index.insert(record.address, m_rows.size());
+            m_rows.append(record);
+        }
+        endInsertRows();
+    }
+}
+
+void DeviceTableModel::removeAddresses(const QVector<DeviceAddress> &removed)
+{
+    QVector<int> rows;
+    for (const DeviceAddress &address : removed) {
+        auto it = m_index.constFind(address);
+        if (it != m_index.constEnd()) {
+            rows.append(*it);
+        }
+    }
+    if (rows.isEmpty()) {
+        return;
+    }
+    // 从后往前按连续区间删除，前面的行号不受影响
+    std::sort(rows.begin(), rows.end(), std::greater<int>());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    for (int i = 0; i < rows.size();) {
+        const int last = rows.at(i);
+        int first = last;
+        while (++i < rows.size() && rows.at(i) == first - 1) {
+            first = rows.at(i);
+        }
+        beginRemoveRows(QModelIndex(), first, last);
+        m_rows.remove(first, last - first + 1);
+        endRemoveRows();
+    }
+    for (const DeviceAddress &address : removed) {
+        m_index.remove(address);
+    }
+    // 只有最前面被删行之后的行号改变
+    for (int row = rows.last(); row < m_rows.size(); ++row) {
+        m_index[m_rows.at(row).address] = row;
+    }
+}
+
+void DeviceTableModel::clear()
+{
+    beginResetModel();
+    m_rows.clear();
+    m_index.clear();
+    endResetModel();
+}
@@ -0,0 +1,53 @@
+#ifndef DEVICETABLEMODEL_H
+#define DEVICETABLEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QVector>
+
+#include "deviceregistry.h"
+
+// 结果表：行数据是设备表在界面线程的镜像，按 DeviceRegistry::devicesChanged 成批更新。
+// 一批中的新设备一次追加，更新只发一个 dataChanged，过期设备按连续区间删除，
+// 上万行时每批的开销与批大小相关而与总行数基本无关
+class DeviceTableModel : public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+    enum Column {
+        AddressColumn,
+        MethodColumn,
+        RttColumn,
+        DeviceIdColumn,
+        OpenPortsColumn,
+        FirstSeenColumn,
+        LastSeenColumn,
+        HeartbeatsColumn,
+        ColumnCount
+    };
+
+    // 排序用的原始值（数值或可按字典序比较的键）
+    static constexpr int SortRole = Qt::UserRole;
+
+    explicit DeviceTableModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    const QVector<DeviceRecord> &records() const { return m_rows; }
+
+public slots:
+    // 先删除过期设备，再更新已有行，最后在末尾追加新设备
+    void applyChanges(const QVector<DeviceRecord> &changed, const QVector<DeviceAddress> &removed);
+    void clear();
+
+private:
+    void removeAddresses(const QVector<DeviceAddress> &removed);
+
+    QVector<DeviceRecord> m_rows;
+    QHash<DeviceAddress, int> m_index;
+};
+
+#endif // DEVICETABLEMODEL_H
@@ -0,0 +1,162 @@
+#include "discoverycapture.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QtEndian>
+
+#include <chrono>
+#include <cstring>
+
+// 每次扩展的文件大小
+constexpr qint64 CAPTURE_CHUNK = 4 << 20;
+
+std::atomic<CaptureWriter *> CaptureWriter::s_active{nullptr};
+
+qint64 CaptureWriter::clockNs()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+CaptureWriter::~CaptureWriter()
+{
+    if (active() == this) {
+        setActive(nullptr);
+    }
+    close();
+}
+
+bool CaptureWriter::open(const QString &path)
+{
+    close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        qWarning() << "Failed to open capture" << path << m_file.errorString();
+        return false;
+    }
+    m_used = 0;
+    m_records = 0;
+    if (!reserve(CAPTURE_HEADER_SIZE)) {
+        m_file.close();
+        return false;
+    }
+    uchar *header = m_map;
+    qToBigEndian<quint32>(CAPTURE_MAGIC, header);
+    qToBigEndian<quint16>(CAPTURE_VERSION, header + 4);
+    qToBigEndian<quint16>(CAPTURE_HEADER_SIZE, header + 6);
+    qToBigEndian<quint64>(quint64(QDateTime::currentMSecsSinceEpoch()), header + 8);
+    qToBigEndian<quint64>(quint64(clockNs()), header + 16);
+    m_used = CAPTURE_HEADER_SIZE;
+    return true;
+}
+
+void CaptureWriter::close()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_map) {
+        return;
+    }
+    m_file.unmap(m_map);
+    m_map = nullptr;
+    m_file.resize(m_used);
+    m_file.close();
+    m_mapped = 0;
+}
+
+bool CaptureWriter::reserve(qint64 bytes)
+{
+    if (m_map && m_used + bytes <= m_mapped) {
+        return true;
+    }
+    // 映射区域不够：解除映射、扩展文件后重新映射
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    const qint64 size = m_mapped + qMax(CAPTURE_CHUNK, bytes);
+    if (!m_file.resize(size)) {
+        qWarning() << "Failed to grow capture" << m_file.fileName() << m_file.errorString();
+        return false;
+    }
+    m_map = m_file.map(0, size);
+    if (!m_map) {
+        qWarning() << "Failed to map capture" << m_file.fileName() << m_file.errorString();
+        return false;
+    }
+    m_mapped = size;
+    return true;
+}
+
+void CaptureWriter::append(CaptureKind kind, const DeviceAddress &address, quint16 port,
+                           const char *data, int size)
+{
+    const qint64 now = clockNs();
+    QMutexLocker locker(&m_mutex);
+    if (!m_map || !reserve(CAPTURE_RECORD_HEADER_SIZE + size)) {
+        return;
+    }
+    uchar *out = m_map + m_used;
+    qToBigEndian<quint64>(quint64(now), out);
+    out[8] = quint8(kind);
+    out[9] = 0;
+    qToBigEndian<quint16>(port, out + 10);
+    qToBigEndian<quint32>(quint32(size), out + 12);
+    qToBigEndian<quint64>(address.hi, out + 16);
+    qToBigEndian<quint64>(address.lo, out + 24);
+    if (size > 0) {
+        std::memcpy(out + CAPTURE_RECORD_HEADER_SIZE, data, size_t(size));
+    }
+    m_used += CAPTURE_RECORD_HEADER_SIZE + size;
+    ++m_records;
+}
+
+CaptureReader::~CaptureReader()
+{
+    if (m_map) {
+        m_file.unmap(const_cast<uchar *>(m_map));
+    }
+}
+
+bool CaptureReader::open(const QString &path)
+{
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Failed to open capture" << path << m_file.errorString();
+        return false;
+    }
+    m_size = m_file.size();
+    m_map = m_size >= CAPTURE_HEADER_SIZE ? m_file.map(0, m_size) : nullptr;
+    if (!m_map || qFromBigEndian<quint32>(m_map) != CAPTURE_MAGIC
+        || qFromBigEndian<quint16>(m_map + 4) != CAPTURE_VERSION) {
+        qWarning() << "Not a capture file:" << path;
+        return false;
+    }
+    const int headerSize = qFromBigEndian<quint16>(m_map + 6);
+    m_wallStartMs = qint64(qFromBigEndian<quint64>(m_map + 8));
+    m_clockStartNs = qint64(qFromBigEndian<quint64>(m_map + 16));
+    m_offset = qMax(headerSize, CAPTURE_HEADER_SIZE);
+    return true;
+}
+
+bool CaptureReader::next(CaptureRecord *record)
+{
+    if (!m_map || m_offset + CAPTURE_RECORD_HEADER_SIZE > m_size) {
+        return false;
+    }
+    const uchar *in = m_map + m_offset;
+    const quint8 kind = in[8];
+    const quint32 size = qFromBigEndian<quint32>(in + 12);
+    if (kind == quint8(CaptureKind::End) || kind > quint8(CaptureKind::TcpReceived)
+        || qint64(size) > m_size - m_offset - CAPTURE_RECORD_HEADER_SIZE) {
+        return false;
+    }
+    record->timestampNs = qint64(qFromBigEndian<quint64>(in));
+    record->kind = CaptureKind(kind);
+    record->port = qFromBigEndian<quint16>(in + 10);
+    record->address.hi = qFromBigEndian<quint64>(in + 16);
+    record->address.lo = qFromBigEndian<quint64>(in + 24);
+    record->data = reinterpret_cast<const char *>(in + CAPTURE_RECORD_HEADER_SIZE);
+    record->size = int(size);
+    m_offset += CAPTURE_RECORD_HEADER_SIZE + size;
+    return true;
+}
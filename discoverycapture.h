@@ -0,0 +1,96 @@
+#ifndef DISCOVERYCAPTURE_H
+#define DISCOVERYCAPTURE_H
+
+#include <QFile>
+#include <QMutex>
+#include <QString>
+
+#include <atomic>
+
+#include "deviceaddress.h"
+
+// 抓包文件格式（大端）：
+//   文件头 32 字节：magic u32 'MTCP'、version u16、头长 u16、
+//                   开始时的墙钟 ms u64、开始时的单调时钟 ns u64、保留 u64
+//   记录  32 字节头 + 负载：timestamp u64（单调时钟 ns，与 SubnetSweeper::clockUs 同源）、
+//                   kind u8、保留 u8、port u16、length u32、address 16 字节（IPv4 为映射形式）
+// 文件按块预分配，未写入部分为 0；读取时遇到 kind 为 0 或不完整的记录即结束，
+// 因此进程异常退出后已写入的记录仍可读取
+constexpr quint32 CAPTURE_MAGIC = 0x4D544350;
+constexpr quint16 CAPTURE_VERSION = 1;
+constexpr int CAPTURE_HEADER_SIZE = 32;
+constexpr int CAPTURE_RECORD_HEADER_SIZE = 32;
+
+enum class CaptureKind : quint8 {
+    End = 0,
+    ProbeSent = 1,          // 发出的探测（广播、扫描、IPv6、在线检测）
+    ReplySent = 2,          // 监听发出的应答
+    DatagramReceived = 3,
+    TcpReceived = 4,        // TCP 连接上收到的一段数据
+};
+
+// 记录视图，data 指向映射的文件内容，只在读取器存活期间有效
+struct CaptureRecord {
+    qint64 timestampNs = 0;
+    CaptureKind kind = CaptureKind::End;
+    DeviceAddress address;
+    quint16 port = 0;
+    const char *data = nullptr;
+    int size = 0;
+};
+
+// 只追加的抓包写入器：文件按块扩展并映射到内存，每条记录只是一次 memcpy。
+// 同一时刻至多一个写入器处于活动状态，各发送与接收点通过 active() 判断是否需要记录
+class CaptureWriter {
+public:
+    CaptureWriter() = default;
+    ~CaptureWriter();
+
+    bool open(const QString &path);
+    // 截掉预分配的空白部分并关闭文件
+    void close();
+    bool isOpen() const { return m_map != nullptr; }
+
+    void append(CaptureKind kind, const DeviceAddress &address, quint16 port, const char *data, int size);
+
+    quint64 records() const { return m_records; }
+
+    static CaptureWriter *active() { return s_active.load(std::memory_order_acquire); }
+    static void setActive(CaptureWriter *writer) { s_active.store(writer, std::memory_order_release); }
+
+    // 与 SubnetSweeper::clockUs 同源的单调时钟
+    static qint64 clockNs();
+
+private:
+    bool reserve(qint64 bytes);
+
+    static std::atomic<CaptureWriter *> s_active;
+
+    QFile m_file;
+    QMutex m_mutex;
+    uchar *m_map = nullptr;
+    qint64 m_mapped = 0;
+    qint64 m_used = 0;
+    quint64 m_records = 0;
+};
+
+class CaptureReader {
+public:
+    ~CaptureReader();
+
+    bool open(const QString &path);
+    bool next(CaptureRecord *record);
+
+    qint64 wallStartMs() const { return m_wallStartMs; }
+    qint64 clockStartNs() const { return m_clockStartNs; }
+
+private:
+    QFile m_file;
+    const uchar *m_map = nullptr;
+    qint64 m_size = 0;
+    qint64 m_offset = 0;
+    qint64 m_wallStartMs = 0;
+    qint64 m_clockStartNs = 0;
+};
+
+#endif // DISCOVERYCAPTURE_H
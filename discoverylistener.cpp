@@ -0,0 +1,342 @@
+#include "discoverylistener.h"
+
+#include "subnetsweeper.h"
+#include "discoverycapture.h"
+#include "discoverymetrics.h"
+#include "networkutils.h"
+
+#ifdef Q_OS_LINUX
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+DiscoveryListener::DiscoveryListener(Role role, QObject *parent)
+    : QObject(parent)
+    , m_role(role)
+{
+    m_tcpServer = new ConnectionManager(this);
+    m_udpSocket = new QUdpSocket(this);
+    m_udpSocket->setSocketOption(QAbstractSocket::MulticastLoopbackOption, 1);
+    m_reply.reserve(FRAME_HEADER_SIZE * 8);
+
+    connect(m_tcpServer, &ConnectionManager::clientConnected, this, [this](QTcpSocket *client) {
+        if (m_role == Role::Finder) {
+            FINDER_TRACE() << "Tcp connection" << client->peerAddress();
+            emit tcpClientConnected(client->peerAddress());
+        } else {
+            notifyMessage(DeviceAddress::fromHostAddress(client->peerAddress()));
+        }
+    });
+    connect(m_tcpServer, &ConnectionManager::clientReadyRead, this, &DiscoveryListener::handleTcpData);
+    connect(m_tcpServer, &ConnectionManager::clientClosed, this, [this](QTcpSocket *client) {
+        m_tcpParsers.remove(client);
+    });
+}
+
+void DiscoveryListener::setPorts(quint16 tcpPort, quint16 udpPort)
+{
+    m_tcp_listen = tcpPort;
+    m_udp_listen = udpPort;
+}
+
+void DiscoveryListener::setMaxTcpClients(int maxClients)
+{
+    m_tcpServer->setMaxClients(maxClients);
+}
+
+void DiscoveryListener::start()
+{
+    FINDER_TRACE() << "startListening" << m_tcp_listen << m_udp_listen;
+    m_started = true;
+    const qintptr tcpFd = m_reusePort ? openReusePort(true, m_tcp_listen) : -1;
+    if (tcpFd == -1 || !m_tcpServer->listen(tcpFd)) {
+        m_tcpServer->listen(QHostAddress::Any, m_tcp_listen);
+    }
+    const qintptr udpFd = m_reusePort ? openReusePort(false, m_udp_listen) : -1;
+    if (udpFd == -1 || !m_udpSocket->setSocketDescriptor(udpFd, QAbstractSocket::BoundState)) {
+        if (!m_udpSocket->bind(m_udp_listen)) {
+            qWarning() << "Failed to bind udp" << m_udp_listen << m_udpSocket->errorString();
+        }
+    }
+    attach(m_udpSocket);
+
+    // 设备端加入项目组播组，IPv6 查找端按组播探测；ff02::1 无需加入
+    if (m_role == Role::Device) {
+        const QHostAddress group(IPV6_DISCOVERY_GROUP);
+        foreach (const QNetworkInterface &interface, NetworkUtils::getIpv6Interfaces()) {
+            if (!m_udpSocket->joinMulticastGroup(group, interface)) {
+                FINDER_TRACE() << "Join" << group << "on" << interface.name() << "failed";
+            }
+        }
+    }
+}
+
+void DiscoveryListener::rebind(quint16 tcpPort, quint16 udpPort)
+{
+    setPorts(tcpPort, udpPort);
+    if (!m_started) {
+        return;
+    }
+    // start() 在重新绑定后挂接新的接收器；套接字对象本身保留，
+    // 策略持有的默认套接字指针仍然有效
+    close();
+    start();
+}
+
+void DiscoveryListener::close()
+{
+    if (!m_started) {
+        return;
+    }
+    m_started = false;
+    // 可能正处于该接收器的回调中，停止后延后释放
+    detach(m_udpSocket);
+    for (DatagramReceiver *receiver : m_udpSocket->findChildren<DatagramReceiver *>(QString(), Qt::FindDirectChildrenOnly)) {
+        receiver->deleteLater();
+    }
+    m_udpSocket->close();
+    m_tcpServer->close();
+    m_tcpParsers.clear();
+}
+
+bool DiscoveryListener::isListening() const
+{
+    return m_udpSocket->state() == QAbstractSocket::BoundState;
+}
+
+void DiscoveryListener::detach(QUdpSocket *socket)
+{
+    for (DatagramReceiver *receiver : socket->findChildren<DatagramReceiver *>(QString(), Qt::FindDirectChildrenOnly)) {
+        receiver->stop();
+    }
+}
+
+void DiscoveryListener::attach(QUdpSocket *socket)
+{
+    DatagramReceiver *receiver = new DatagramReceiver(socket, nullptr, socket);
+    receiver->setHandler([this, socket, receiver](const DatagramView &view) {
+        m_receiving = receiver;
+        handleDatagram(socket, view);
+        m_receiving = nullptr;
+    });
+    receiver->setBatchReplies(m_batchReplies);
+    receiver->start();
+}
+
+void DiscoveryListener::handleDatagram(QUdpSocket *socket, const DatagramView &view)
+{
+    // 热路径：不拷贝、不打日志，只在需要应答时构造地址
+    countMetric(MetricCounter::DatagramsReceived);
+    if (CaptureWriter *capture = CaptureWriter::active()) {
+        // 回放（socket 为空）的数据不再写回抓包
+        if (socket && view.hasSender()) {
+            capture->append(CaptureKind::DatagramReceived, view.senderAddress(), view.senderPort,
+                            view.data, view.size);
+        }
+    }
+    if (m_role == Role::Device) {
+        notifyMessage(view.hasSender() ? view.senderAddress() : DeviceAddress());
+    }
+    if (!view.hasSender()) {
+        return;
+    }
+    if (!DiscoveryProtocol::looksLikeFrame(view.data, view.size)) {
+        // 旧设备的纯字符串心跳
+        if (view.equals(HEARTBEAT)) {
+            const QByteArray &reply = m_role == Role::Finder ? EXIT_MESSAGE : HEARTBEAT;
+            sendReply(socket, reply, view);
+            if (m_role == Role::Finder) {
+                countMetric(MetricCounter::RepliesReceived);
+                emit heartbeat(view.senderAddress(), -1, 0, 0);
+            }
+        }
+        return;
+    }
+
+    // 一个数据报可能合并了多帧，应答合并到一个数据报中发回
+    m_reply.resize(0);
+    DiscoveryProtocol::parseDatagram(view.data, view.size, [&](const Frame &frame) {
+        handleFrame(frame, view.senderAddress(), m_reply);
+    });
+    if (!m_reply.isEmpty()) {
+        sendReply(socket, m_reply, view);
+    }
+}
+
+void DiscoveryListener::replayDatagram(const DeviceAddress &sender, quint16 port, const char *data, int size)
+{
+    quint8 bytes[16];
+    DatagramView view;
+    view.data = data;
+    view.size = size;
+    view.senderPort = port;
+    if (sender.isIpv4()) {
+        view.senderV4 = sender.toIpv4();
+    } else {
+        qToBigEndian<quint64>(sender.hi, bytes);
+        qToBigEndian<quint64>(sender.lo, bytes + 8);
+        view.senderV6 = bytes;
+    }
+    handleDatagram(nullptr, view);
+}
+
+void DiscoveryListener::replayTcp(const DeviceAddress &peer, quint16 port, const char *data, int size)
+{
+    QByteArray reply;
+    handleStream(m_replayParsers[qMakePair(peer, port)], QByteArray::fromRawData(data, size), peer, reply);
+}
+
+void DiscoveryListener::sendReply(QUdpSocket *socket, const QByteArray &reply, const DatagramView &view)
+{
+    // 回放时没有套接字，应答只在处理逻辑中生成
+    if (!socket) {
+        return;
+    }
+    if (CaptureWriter *capture = CaptureWriter::active()) {
+        capture->append(CaptureKind::ReplySent, view.senderAddress(), view.senderPort,
+                        reply.constData(), reply.size());
+    }
+    // 批量应答由接收器在本批处理完后统一发出并计数
+    if (m_batchReplies && m_receiving && m_receiving->queueReply(reply)) {
+        return;
+    }
+    if (socket->writeDatagram(reply, view.senderHost(), view.senderPort) < 0) {
+        countMetric(MetricCounter::SendErrors);
+    } else {
+        countMetric(MetricCounter::RepliesSent);
+    }
+}
+
+void DiscoveryListener::notifyMessage(const DeviceAddress &peer)
+{
+    if (!m_sessions) {
+        emit messageReceived();
+        return;
+    }
+    if (!peer.isNull() && m_sessions->touch(peer, SubnetSweeper::clockUs())) {
+        emit messageReceived();
+    }
+}
+
+qintptr DiscoveryListener::openReusePort(bool tcp, quint16 port)
+{
+#ifdef Q_OS_LINUX
+    const int fd = ::socket(AF_INET6, (tcp ? SOCK_STREAM : SOCK_DGRAM) | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    const int on = 1;
+    const int off = 0;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+    // 与 QUdpSocket / QTcpServer 绑定 Any 时一样接受 IPv4 映射地址
+    ::setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+    sockaddr_in6 addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin6_family = AF_INET6;
+    addr.sin6_port = htons(port);
+    addr.sin6_addr = in6addr_any;
+    if (::bind(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) < 0
+        || (tcp && ::listen(fd, SOMAXCONN) < 0)) {
+        qWarning() << "Failed to bind reuseport" << (tcp ? "tcp" : "udp") << port << std::strerror(errno);
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+#else
+    Q_UNUSED(tcp);
+    Q_UNUSED(port);
+    return -1;
+#endif
+}
+
+void DiscoveryListener::handleTcpData(QTcpSocket *client)
+{
+    const QByteArray data = client->readAll();
+    const DeviceAddress address = DeviceAddress::fromHostAddress(client->peerAddress());
+    if (CaptureWriter *capture = CaptureWriter::active()) {
+        capture->append(CaptureKind::TcpReceived, address, client->peerPort(), data.constData(), data.size());
+    }
+    if (m_role == Role::Device && m_sessions) {
+        notifyMessage(address);
+    }
+    const bool ok = handleStream(m_tcpParsers[client], data, address, m_reply);
+    if (!m_reply.isEmpty()) {
+        client->write(m_reply);
+    }
+    if (!ok) {
+        qWarning() << "Malformed frame from" << client->peerAddress();
+        client->close();
+    }
+}
+
+bool DiscoveryListener::handleStream(FrameParser &parser, const QByteArray &data,
+                                     const DeviceAddress &address, QByteArray &out)
+{
+    out.resize(0);
+    parser.append(data);
+
+    if (parser.isLegacy()) {
+        // 旧协议：按字符串匹配，允许多条心跳粘连
+        if (m_role == Role::Device) {
+            out = HEARTBEAT;
+        } else if (parser.containsLegacy(HEARTBEAT)) {
+            out = EXIT_MESSAGE;
+            countMetric(MetricCounter::RepliesReceived);
+            if (!address.isNull()) {
+                emit heartbeat(address, -1, 0, 0);
+            }
+        }
+        return true;
+    }
+
+    Frame frame;
+    while (parser.next(&frame)) {
+        handleFrame(frame, address, out);
+    }
+    return !parser.hasError();
+}
+
+void DiscoveryListener::handleFrame(const Frame &frame, const DeviceAddress &address, QByteArray &out)
+{
+    Frame reply;
+    reply.sequence = frame.sequence;
+    reply.timestampUs = frame.timestampUs;
+
+    if (m_role == Role::Finder) {
+        if (frame.type != FrameType::Heartbeat) {
+            return;
+        }
+        // 在线检测的应答不回 EXIT，避免每个心跳周期多一个数据报
+        if (!(frame.sequence & LIVENESS_SEQUENCE_FLAG)) {
+            reply.type = FrameType::Exit;
+            DiscoveryProtocol::appendFrame(out, reply);
+        }
+        countMetric(MetricCounter::RepliesReceived);
+        if (!address.isNull()) {
+            emit heartbeat(address, echoedRtt(frame), frame.deviceId, frame.sequence);
+        }
+        return;
+    }
+
+    // 探测与心跳都以心跳应答，回显序号和时间戳供对端计算 RTT
+    if (frame.type != FrameType::Probe && frame.type != FrameType::Heartbeat) {
+        return;
+    }
+    reply.type = FrameType::Heartbeat;
+    reply.deviceId = m_deviceId;
+    DiscoveryProtocol::appendFrame(out, reply);
+}
+
+qint64 DiscoveryListener::echoedRtt(const Frame &frame)
+{
+    if (frame.timestampUs == 0) {
+        return -1;
+    }
+    // 回显的是本机单调时钟；超出合理范围视为无效
+    const qint64 rtt = SubnetSweeper::clockUs() - qint64(frame.timestampUs);
+    return rtt >= 0 && rtt < 60000000 ? rtt : -1;
+}
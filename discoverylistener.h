@@ -0,0 +1,122 @@
+#ifndef DISCOVERYLISTENER_H
+#define DISCOVERYLISTENER_H
+
+#include <QObject>
+#include <QUdpSocket>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QHash>
+#include <QPair>
+
+#include "connectionmanager.h"
+#include "datagramreceiver.h"
+#include "discoveryprotocol.h"
+#include "deviceaddress.h"
+#include "sessiontable.h"
+
+// 查找端与设备端共用的 UDP/TCP 监听：收包、解帧、兼容旧字符串协议并批量应答。
+// Finder 角色应答心跳并上报设备；Device 角色以心跳应答探测。
+class DiscoveryListener : public QObject {
+    Q_OBJECT
+
+public:
+    enum class Role {
+        Finder,
+        Device,
+    };
+
+    explicit DiscoveryListener(Role role, QObject *parent = nullptr);
+
+    void setPorts(quint16 tcpPort, quint16 udpPort);
+    void setMaxTcpClients(int maxClients);
+
+    // Device 角色在心跳帧中上报的设备 ID
+    void setDeviceId(quint64 id) { m_deviceId = id; }
+
+    // 以 SO_REUSEPORT 绑定 UDP 与 TCP 端口（仅 Linux），多个监听可共享同一端口，
+    // 由内核按对端分流。须在 start() 之前设置
+    void setReusePort(bool enabled) { m_reusePort = enabled; }
+
+    // 一批接收的数据报处理完后用一次 sendmmsg 发出全部应答
+    void setBatchReplies(bool enabled) { m_batchReplies = enabled; }
+
+    // Device 角色：按对端记录会话，messageReceived 只在出现新会话时发出
+    void setSessions(SessionTable *sessions) { m_sessions = sessions; }
+
+    void start();
+
+    // 关闭当前监听并在新端口上重新监听；尚未 start() 时只记录端口
+    void rebind(quint16 tcpPort, quint16 udpPort);
+
+    // 关闭 UDP 套接字、TCP 监听与全部客户端；可在接收回调中调用
+    void close();
+    // 主 UDP 套接字是否已绑定
+    bool isListening() const;
+
+    // 主 UDP 套接字：绑定监听端口，同时用作默认发送套接字
+    QUdpSocket *udpSocket() const { return m_udpSocket; }
+
+    // 让其它已绑定的 UDP 套接字（如每网卡发送套接字）走同一接收与应答路径
+    void attach(QUdpSocket *socket);
+    // 停止 attach() 挂接的接收；套接字由调用方关闭和释放
+    static void detach(QUdpSocket *socket);
+
+    // 离线回放：把抓包中的数据报或 TCP 数据送入与实时接收相同的处理路径，不发送应答
+    void replayDatagram(const DeviceAddress &sender, quint16 port, const char *data, int size);
+    // TCP 解帧状态按对端地址与端口（即每条连接）分开保存
+    void replayTcp(const DeviceAddress &peer, quint16 port, const char *data, int size);
+    // 回放结束后丢弃按连接保存的 TCP 解帧状态
+    void resetReplay() { m_replayParsers.clear(); }
+
+signals:
+    // Finder：收到设备心跳；rttUs 由回显时间戳得出，旧协议为 -1；
+    // sequence 为回显的探测序号，旧协议为 0
+    void heartbeat(const DeviceAddress &address, qint64 rttUs, quint64 deviceId, quint32 sequence);
+
+    // Finder：设备建立了 TCP 连接
+    void tcpClientConnected(const QHostAddress &peer);
+
+    // Device：收到任意数据报或 TCP 连接；设置了会话表时只在新对端出现时发出
+    void messageReceived();
+
+private:
+    void handleDatagram(QUdpSocket *socket, const DatagramView &view);
+
+    // 有会话表时记录对端并只对新会话发出 messageReceived
+    void notifyMessage(const DeviceAddress &peer);
+
+    // 打开设置了 SO_REUSEPORT 的双栈套接字并绑定端口，TCP 同时开始 listen；失败返回 -1
+    static qintptr openReusePort(bool tcp, quint16 port);
+
+    void sendReply(QUdpSocket *socket, const QByteArray &reply, const DatagramView &view);
+
+    void handleTcpData(QTcpSocket *client);
+
+    // 处理 TCP 流上新到的数据，应答写入 out；帧格式错误时返回 false
+    bool handleStream(FrameParser &parser, const QByteArray &data, const DeviceAddress &address,
+                      QByteArray &out);
+
+    // 处理一帧，应答追加到 out；Finder 角色同时上报心跳
+    void handleFrame(const Frame &frame, const DeviceAddress &address, QByteArray &out);
+
+    // 由应答帧回显的时间戳计算 RTT，无效时返回 -1
+    static qint64 echoedRtt(const Frame &frame);
+
+    Role m_role;
+    ConnectionManager *m_tcpServer;
+    QUdpSocket *m_udpSocket;
+    QHash<QTcpSocket *, FrameParser> m_tcpParsers;
+    QHash<QPair<DeviceAddress, quint16>, FrameParser> m_replayParsers;
+    QByteArray m_reply;
+    quint64 m_deviceId = 0;
+    bool m_started = false;
+    bool m_reusePort = false;
+    bool m_batchReplies = false;
+    SessionTable *m_sessions = nullptr;
+    DatagramReceiver *m_receiving = nullptr;    // 正在回调的接收器，批量应答经它排队
+
+    quint16 m_tcp_listen = TCP_LISTEN_PORT;
+    quint16 m_udp_listen = UDP_LISTEN_PORT;
+};
+
+#endif // DISCOVERYLISTENER_H
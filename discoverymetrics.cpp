@@ -0,0 +1,166 @@
+#include "discoverymetrics.h"
+
+#include <QJsonArray>
+#include <QtAlgorithms>
+
+namespace {
+int bucketFor(qint64 us)
+{
+    if (us <= 1) {
+        return 0;
+    }
+    int bucket = 63 - int(qCountLeadingZeroBits(quint64(us)));
+    return qMin(bucket, METRICS_HISTOGRAM_BUCKETS - 1);
+}
+}
+
+const char *metricCounterName(MetricCounter counter)
+{
+    switch (counter) {
+    case MetricCounter::ProbesSent: return "probes_sent";
+    case MetricCounter::SendErrors: return "send_errors";
+    case MetricCounter::SendBlocked: return "send_blocked";
+    case MetricCounter::DatagramsReceived: return "datagrams_received";
+    case MetricCounter::RepliesReceived: return "replies_received";
+    case MetricCounter::RepliesSent: return "replies_sent";
+    case MetricCounter::DevicesFound: return "devices_found";
+    case MetricCounter::TcpAccepted: return "tcp_accepted";
+    case MetricCounter::TcpRejected: return "tcp_rejected";
+    case MetricCounter::TcpClosed: return "tcp_closed";
+    case MetricCounter::TcpIdleTimeouts: return "tcp_idle_timeouts";
+    case MetricCounter::LivenessProbesSent: return "liveness_probes_sent";
+    case MetricCounter::LivenessRepliesReceived: return "liveness_replies_received";
+    case MetricCounter::DevicesDown: return "devices_down";
+    case MetricCounter::ServiceConnects: return "service_connects";
+    case MetricCounter::ServicePortsOpen: return "service_ports_open";
+    case MetricCounter::ServiceTimeouts: return "service_timeouts";
+    default: return "unknown";
+    }
+}
+
+qint64 HistogramSnapshot::percentileUs(double p) const
+{
+    if (count == 0) {
+        return -1;
+    }
+    const quint64 rank = quint64(p * double(count - 1)) + 1;
+    quint64 seen = 0;
+    for (int i = 0; i < METRICS_HISTOGRAM_BUCKETS; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return (qint64(1) << (i + 1)) - 1;
+        }
+    }
+    return (qint64(1) << METRICS_HISTOGRAM_BUCKETS) - 1;
+}
+
+QJsonObject HistogramSnapshot::toJson() const
+{
+    QJsonObject object;
+    object.insert(QStringLiteral("count"), double(count));
+    object.insert(QStringLiteral("mean_us"), count ? double(sumUs) / double(count) : 0.0);
+    object.insert(QStringLiteral("p50_us"), double(percentileUs(0.5)));
+    object.insert(QStringLiteral("p99_us"), double(percentileUs(0.99)));
+    // 只输出到最后一个非空桶
+    int last = METRICS_HISTOGRAM_BUCKETS - 1;
+    while (last >= 0 && buckets[last] == 0) {
+        --last;
+    }
+    QJsonArray array;
+    for (int i = 0; i <= last; ++i) {
+        array.append(double(buckets[i]));
+    }
+    object.insert(QStringLiteral("log2_buckets"), array);
+    return object;
+}
+
+QJsonObject MetricsSnapshot::toJson() const
+{
+    QJsonObject counterObject;
+    for (int i = 0; i < int(MetricCounter::Count); ++i) {
+        counterObject.insert(QLatin1String(metricCounterName(MetricCounter(i))), double(counters[i]));
+    }
+    QJsonObject latencyObject;
+    for (int i = 0; i < METRICS_METHOD_COUNT; ++i) {
+        if (discoveryLatency[i].count > 0) {
+            latencyObject.insert(QLatin1String(discoveryMethodName(DiscoveryMethod(i))),
+                                 discoveryLatency[i].toJson());
+        }
+    }
+
+    QJsonObject object;
+    object.insert(QStringLiteral("counters"), counterObject);
+    object.insert(QStringLiteral("discovery_latency"), latencyObject);
+    object.insert(QStringLiteral("reply_rtt"), replyRtt.toJson());
+    return object;
+}
+
+DiscoveryMetrics &DiscoveryMetrics::instance()
+{
+    static DiscoveryMetrics metrics;
+    return metrics;
+}
+
+void DiscoveryMetrics::recordDiscovery(DiscoveryMethod method, qint64 latencyUs)
+{
+    const int index = int(method);
+    if (index >= 0 && index < METRICS_METHOD_COUNT && latencyUs >= 0) {
+        m_latency[index].record(latencyUs);
+    }
+}
+
+void DiscoveryMetrics::recordRtt(qint64 rttUs)
+{
+    if (rttUs >= 0) {
+        m_rtt.record(rttUs);
+    }
+}
+
+MetricsSnapshot DiscoveryMetrics::snapshot() const
+{
+    MetricsSnapshot snapshot;
+    for (int i = 0; i < int(MetricCounter::Count); ++i) {
+        snapshot.counters[i] = m_counters[i].load(std::memory_order_relaxed);
+    }
+    for (int i = 0; i < METRICS_METHOD_COUNT; ++i) {
+        m_latency[i].read(&snapshot.discoveryLatency[i]);
+    }
+    m_rtt.read(&snapshot.replyRtt);
+    return snapshot;
+}
+
+void DiscoveryMetrics::reset()
+{
+    for (auto &counter : m_counters) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+    for (Histogram &histogram : m_latency) {
+        histogram.reset();
+    }
+    m_rtt.reset();
+}
+
+void DiscoveryMetrics::Histogram::record(qint64 us)
+{
+    count.fetch_add(1, std::memory_order_relaxed);
+    sumUs.fetch_add(quint64(us), std::memory_order_relaxed);
+    buckets[bucketFor(us)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void DiscoveryMetrics::Histogram::read(HistogramSnapshot *out) const
+{
+    out->count = count.load(std::memory_order_relaxed);
+    out->sumUs = sumUs.load(std::memory_order_relaxed);
+    for (int i = 0; i < METRICS_HISTOGRAM_BUCKETS; ++i) {
+        out->buckets[i] = buckets[i].load(std::memory_order_relaxed);
+    }
+}
+
+void DiscoveryMetrics::Histogram::reset()
+{
+    count.store(0, std::memory_order_relaxed);
+    sumUs.store(0, std::memory_order_relaxed);
+    for (auto &bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
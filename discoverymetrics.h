@@ -0,0 +1,105 @@
+#ifndef DISCOVERYMETRICS_H
+#define DISCOVERYMETRICS_H
+
+#include <QtGlobal>
+#include <QDebug>
+#include <QJsonObject>
+
+#include <atomic>
+
+#include "devicecache.h"
+
+// 编译期可移除的跟踪点：定义 FINDER_ENABLE_TRACE（CMake 选项 FINDER_TRACE）时输出到
+// qDebug，否则整条语句被编译器消除，<< 后的参数不会求值
+#ifdef FINDER_ENABLE_TRACE
+#define FINDER_TRACE() qDebug()
+#else
+#define FINDER_TRACE() while (false) QMessageLogger().noDebug()
+#endif
+
+enum class MetricCounter : int {
+    ProbesSent,         // 发出的探测包
+    SendErrors,         // 发送失败（writeDatagram / sendmmsg 返回错误）
+    SendBlocked,        // 发送缓冲区满，留到下一节拍重发
+    DatagramsReceived,  // 监听收到的数据报
+    RepliesReceived,    // 收到的设备心跳
+    RepliesSent,        // 发出的应答数据报（EXIT / 心跳）
+    DevicesFound,       // 设备表新增的设备
+    TcpAccepted,
+    TcpRejected,        // 已 accept 但超出连接上限被复位
+    TcpClosed,
+    TcpIdleTimeouts,
+    LivenessProbesSent,     // 在线检测心跳
+    LivenessRepliesReceived,
+    DevicesDown,            // 在线检测判定离线的次数
+    ServiceConnects,        // 服务探测发起的 TCP 连接
+    ServicePortsOpen,
+    ServiceTimeouts,        // 连接超时（端口被过滤或主机无应答）
+    Count
+};
+
+const char *metricCounterName(MetricCounter counter);
+
+// 以 2 的幂划分的延迟直方图：桶 i 统计 [2^i, 2^(i+1)) us，桶 0 还包含 0
+constexpr int METRICS_HISTOGRAM_BUCKETS = 32;
+constexpr int METRICS_METHOD_COUNT = 6;     // DiscoveryMethod 的取值个数
+
+struct HistogramSnapshot {
+    quint64 count = 0;
+    quint64 sumUs = 0;
+    quint64 buckets[METRICS_HISTOGRAM_BUCKETS] = {};
+
+    // 近似分位数：返回所在桶的上界，无样本时返回 -1
+    qint64 percentileUs(double p) const;
+    QJsonObject toJson() const;
+};
+
+struct MetricsSnapshot {
+    quint64 counters[int(MetricCounter::Count)] = {};
+    // 从开始发现到设备首次出现的时间，按发现方式分组
+    HistogramSnapshot discoveryLatency[METRICS_METHOD_COUNT];
+    HistogramSnapshot replyRtt;
+
+    quint64 value(MetricCounter counter) const { return counters[int(counter)]; }
+    QJsonObject toJson() const;
+};
+
+// 进程级的发现指标。计数与直方图均为 relaxed 原子操作，可在网络线程中
+// 无锁更新，任意线程随时取快照
+class DiscoveryMetrics {
+public:
+    static DiscoveryMetrics &instance();
+
+    void add(MetricCounter counter, quint64 n = 1) {
+        m_counters[int(counter)].fetch_add(n, std::memory_order_relaxed);
+    }
+
+    void recordDiscovery(DiscoveryMethod method, qint64 latencyUs);
+    void recordRtt(qint64 rttUs);
+
+    MetricsSnapshot snapshot() const;
+    void reset();
+
+private:
+    struct Histogram {
+        std::atomic<quint64> count{0};
+        std::atomic<quint64> sumUs{0};
+        std::atomic<quint64> buckets[METRICS_HISTOGRAM_BUCKETS] = {};
+
+        void record(qint64 us);
+        void read(HistogramSnapshot *out) const;
+        void reset();
+    };
+
+    std::atomic<quint64> m_counters[int(MetricCounter::Count)] = {};
+    Histogram m_latency[METRICS_METHOD_COUNT];
+    Histogram m_rtt;
+};
+
+// 热路径计数的简写
+inline void countMetric(MetricCounter counter, quint64 n = 1)
+{
+    DiscoveryMetrics::instance().add(counter, n);
+}
+
+#endif // DISCOVERYMETRICS_H
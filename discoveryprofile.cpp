@@ -0,0 +1,231 @@
+#include "discoveryprofile.h"
+
+#include <QSettings>
+#include <QRunnable>
+#include <QDebug>
+
+// 合并修改的窗口：连续点击 Apply 或切换配置只写一次
+constexpr int PROFILE_WRITE_DELAY_MS = 500;
+
+namespace {
+const QString PROFILE_GROUP = QStringLiteral("Profiles");
+const QString CURRENT_KEY = QStringLiteral("Profiles/Current");
+const QString LEGACY_GROUP = QStringLiteral("Network");
+
+DiscoveryProfile readProfile(QSettings &settings, const QString &name)
+{
+    DiscoveryProfile profile;
+    profile.name = name;
+    profile.targets = settings.value("IP").toString();
+    for (int i = 0; i < profile.methods.size(); ++i) {
+        profile.methods[i] = settings.value(QStringLiteral("Method%1").arg(i + 1), false).toBool();
+    }
+    profile.tcpPort = quint16(settings.value("TCPPort", TCP_LISTEN_PORT).toUInt());
+    profile.udpPort = quint16(settings.value("UDPPort", UDP_LISTEN_PORT).toUInt());
+    profile.targetUdpPort = quint16(settings.value("TargetUDP", UDP_TARGET_PORT).toUInt());
+    profile.sendRate = settings.value("Frequency", 1000).toInt();
+    profile.continuous = settings.value("Continuous", false).toBool();
+    return profile;
+}
+
+void writeProfile(QSettings &settings, const DiscoveryProfile &profile)
+{
+    settings.setValue("IP", profile.targets);
+    for (int i = 0; i < profile.methods.size(); ++i) {
+        settings.setValue(QStringLiteral("Method%1").arg(i + 1), profile.methods.at(i));
+    }
+    settings.setValue("TCPPort", profile.tcpPort);
+    settings.setValue("UDPPort", profile.udpPort);
+    settings.setValue("TargetUDP", profile.targetUdpPort);
+    settings.setValue("Frequency", profile.sendRate);
+    settings.setValue("Continuous", profile.continuous);
+}
+
+// 后台写入一批修改；upserts 为写入的配置，removals 为删除的配置名
+class ProfileWriteTask : public QRunnable {
+public:
+    ProfileWriteTask(QList<DiscoveryProfile> upserts, QStringList removals, QString current,
+                     bool dropLegacy)
+        : m_upserts(std::move(upserts)), m_removals(std::move(removals)), m_current(std::move(current))
+        , m_dropLegacy(dropLegacy) {}
+
+    void run() override {
+        QSettings settings;
+        settings.beginGroup(PROFILE_GROUP);
+        for (const QString &name : qAsConst(m_removals)) {
+            settings.remove(name);
+        }
+        for (const DiscoveryProfile &profile : qAsConst(m_upserts)) {
+            settings.beginGroup(profile.name);
+            writeProfile(settings, profile);
+            settings.endGroup();
+        }
+        settings.endGroup();
+        if (!m_current.isNull()) {
+            settings.setValue(CURRENT_KEY, m_current);
+        }
+        // 迁移后的配置已写入同一批次，旧的 Network/* 设置不再需要
+        if (m_dropLegacy) {
+            settings.remove(LEGACY_GROUP);
+        }
+        settings.sync();
+        if (settings.status() != QSettings::NoError) {
+            qWarning() << "Failed to save profiles to" << settings.fileName();
+        }
+    }
+
+private:
+    QList<DiscoveryProfile> m_upserts;
+    QStringList m_removals;
+    QString m_current;
+    bool m_dropLegacy;
+};
+}
+
+ProfileStore::ProfileStore(QObject *parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<DiscoveryProfile>("DiscoveryProfile");
+    m_writer.setMaxThreadCount(1);
+    m_writeTimer = new QTimer(this);
+    m_writeTimer->setSingleShot(true);
+    m_writeTimer->setInterval(PROFILE_WRITE_DELAY_MS);
+    connect(m_writeTimer, &QTimer::timeout, this, &ProfileStore::write);
+    load();
+}
+
+ProfileStore::~ProfileStore()
+{
+    flush();
+}
+
+bool ProfileStore::isValidName(const QString &name)
+{
+    const QString trimmed = name.trimmed();
+    return !trimmed.isEmpty() && trimmed == name && !name.contains('/') && !name.contains('\\');
+}
+
+void ProfileStore::load()
+{
+    QSettings settings;
+    settings.beginGroup(PROFILE_GROUP);
+    for (const QString &name : settings.childGroups()) {
+        settings.beginGroup(name);
+        m_profiles.insert(name, readProfile(settings, name));
+        settings.endGroup();
+    }
+    settings.endGroup();
+    m_current = settings.value(CURRENT_KEY).toString();
+
+    if (m_profiles.isEmpty()) {
+        // 旧版本只有一组 Network/* 设置，迁移为默认配置
+        DiscoveryProfile profile;
+        if (settings.childGroups().contains(LEGACY_GROUP)) {
+            settings.beginGroup(LEGACY_GROUP);
+            profile = readProfile(settings, profile.name);
+            settings.endGroup();
+            // 旧的 Frequency 是发送间隔（1-1000 ms），与现在的每秒发送速率含义不同，改用默认速率
+            profile.sendRate = DiscoveryProfile().sendRate;
+            m_legacyDirty = true;
+        }
+        m_profiles.insert(profile.name, profile);
+        m_dirty.insert(profile.name);
+        m_currentDirty = true;
+        scheduleWrite();
+    }
+    if (!m_profiles.contains(m_current)) {
+        m_current = m_profiles.firstKey();
+    }
+}
+
+DiscoveryProfile ProfileStore::profile(const QString &name) const
+{
+    auto it = m_profiles.constFind(name);
+    if (it != m_profiles.constEnd()) {
+        return *it;
+    }
+    DiscoveryProfile profile;
+    profile.name = name;
+    return profile;
+}
+
+void ProfileStore::setCurrent(const QString &name)
+{
+    if (name == m_current || !m_profiles.contains(name)) {
+        return;
+    }
+    m_current = name;
+    m_currentDirty = true;
+    scheduleWrite();
+}
+
+void ProfileStore::save(const DiscoveryProfile &profile)
+{
+    if (!isValidName(profile.name)) {
+        qWarning() << "Invalid profile name" << profile.name;
+        return;
+    }
+    auto it = m_profiles.find(profile.name);
+    if (it != m_profiles.end() && *it == profile) {
+        return;
+    }
+    const bool added = it == m_profiles.end();
+    m_profiles.insert(profile.name, profile);
+    m_dirty.insert(profile.name);
+    scheduleWrite();
+    if (added) {
+        emit profilesChanged();
+    }
+}
+
+void ProfileStore::remove(const QString &name)
+{
+    // 至少保留一个配置
+    if (!m_profiles.contains(name) || m_profiles.size() == 1) {
+        return;
+    }
+    m_profiles.remove(name);
+    m_dirty.insert(name);
+    if (m_current == name) {
+        m_current = m_profiles.firstKey();
+        m_currentDirty = true;
+    }
+    scheduleWrite();
+    emit profilesChanged();
+}
+
+void ProfileStore::scheduleWrite()
+{
+    if (!m_writeTimer->isActive()) {
+        m_writeTimer->start();
+    }
+}
+
+void ProfileStore::write()
+{
+    if (m_dirty.isEmpty() && !m_currentDirty && !m_legacyDirty) {
+        return;
+    }
+    QList<DiscoveryProfile> upserts;
+    QStringList removals;
+    for (const QString &name : qAsConst(m_dirty)) {
+        auto it = m_profiles.constFind(name);
+        if (it == m_profiles.constEnd()) {
+            removals.append(name);
+        } else {
+            upserts.append(*it);
+        }
+    }
+    const QString current = m_currentDirty ? m_current : QString();
+    m_dirty.clear();
+    m_currentDirty = false;
+    m_writer.start(new ProfileWriteTask(upserts, removals, current, m_legacyDirty));
+    m_legacyDirty = false;
+}
+
+void ProfileStore::flush()
+{
+    m_writeTimer->stop();
+    write();
+    m_writer.waitForDone();
+}
@@ -0,0 +1,82 @@
+#ifndef DISCOVERYPROFILE_H
+#define DISCOVERYPROFILE_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QMap>
+#include <QSet>
+#include <QTimer>
+#include <QThreadPool>
+#include <QMetaType>
+
+#include "discoveryprotocol.h"
+
+// 一组发现参数。界面和 DeviceFinder 都按整份配置传递，便于整体切换现场
+struct DiscoveryProfile {
+    QString name = QStringLiteral("Default");
+    QString targets;                        // TargetSpec 格式，空表示按网卡网段发现
+    QVector<bool> methods = {false, false, false, false};  // 广播、mDNS、扫描、IPv6
+    quint16 tcpPort = TCP_LISTEN_PORT;
+    quint16 udpPort = UDP_LISTEN_PORT;
+    quint16 targetUdpPort = UDP_TARGET_PORT;
+    int sendRate = 1000;
+    bool continuous = false;
+
+    bool operator==(const DiscoveryProfile &other) const {
+        return name == other.name && targets == other.targets && methods == other.methods
+            && tcpPort == other.tcpPort && udpPort == other.udpPort
+            && targetUdpPort == other.targetUdpPort && sendRate == other.sendRate
+            && continuous == other.continuous;
+    }
+    bool operator!=(const DiscoveryProfile &other) const { return !(*this == other); }
+};
+Q_DECLARE_METATYPE(DiscoveryProfile)
+
+// 命名配置的存储。构造时一次读入全部配置，之后读操作只访问内存；
+// 写入只记录有变化的配置，合并一段时间内的修改后在后台线程写入 QSettings。
+// 旧版本的 Network/* 键在首次启动时迁移为 "Default" 配置
+class ProfileStore : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ProfileStore(QObject *parent = nullptr);
+    ~ProfileStore() override;
+
+    QStringList names() const { return m_profiles.keys(); }
+    bool contains(const QString &name) const { return m_profiles.contains(name); }
+    DiscoveryProfile profile(const QString &name) const;
+
+    QString currentName() const { return m_current; }
+    DiscoveryProfile current() const { return profile(m_current); }
+    void setCurrent(const QString &name);
+
+    // 新增或更新配置；内容未变时不产生写入
+    void save(const DiscoveryProfile &profile);
+    void remove(const QString &name);
+
+    // 立即提交尚未写入的修改并等待后台写入完成
+    void flush();
+
+    // 配置名会作为 QSettings 分组名，不能为空或含路径分隔符
+    static bool isValidName(const QString &name);
+
+signals:
+    void profilesChanged();
+
+private:
+    void load();
+    void scheduleWrite();
+    void write();
+
+    QMap<QString, DiscoveryProfile> m_profiles;
+    QString m_current;
+    QSet<QString> m_dirty;      // 待写入或待删除的配置名
+    bool m_currentDirty = false;
+    bool m_legacyDirty = false; // 已迁移的旧 Network/* 设置待删除
+    QTimer *m_writeTimer;
+    QThreadPool m_writer;       // 单线程，保证写入顺序
+};
+
+#endif // DISCOVERYPROFILE_H
@@ -0,0 +1,110 @@
+#include "discoveryprotocol.h"
+
+#include <cstring>
+
+namespace DiscoveryProtocol {
+
+void appendFrame(QByteArray &out, const Frame &frame)
+{
+    const int payloadSize = qBound(0, frame.payloadSize, FRAME_MAX_PAYLOAD);
+    const int base = out.size();
+    out.resize(base + FRAME_HEADER_SIZE + payloadSize);
+
+    uchar *p = reinterpret_cast<uchar *>(out.data()) + base;
+    qToBigEndian<quint16>(FRAME_MAGIC, p);
+    p[2] = FRAME_VERSION;
+    p[3] = quint8(frame.type);
+    qToBigEndian<quint16>(quint16(payloadSize), p + 4);
+    qToBigEndian<quint16>(0, p + 6);
+    qToBigEndian<quint32>(frame.sequence, p + 8);
+    qToBigEndian<quint64>(frame.timestampUs, p + FRAME_TIMESTAMP_OFFSET);
+    qToBigEndian<quint64>(frame.deviceId, p + 20);
+    if (payloadSize > 0) {
+        std::memcpy(p + FRAME_HEADER_SIZE, frame.payload, size_t(payloadSize));
+    }
+}
+
+QByteArray encode(const Frame &frame)
+{
+    QByteArray out;
+    out.reserve(FRAME_HEADER_SIZE + frame.payloadSize);
+    appendFrame(out, frame);
+    return out;
+}
+
+ParseResult parseFrame(const char *data, int size, Frame *frame, int *consumed)
+{
+    if (size < FRAME_HEADER_SIZE) {
+        return size >= 2 && !looksLikeFrame(data, size) ? ParseResult::Invalid : ParseResult::NeedMore;
+    }
+
+    const uchar *p = reinterpret_cast<const uchar *>(data);
+    if (qFromBigEndian<quint16>(p) != FRAME_MAGIC || p[2] != FRAME_VERSION) {
+        return ParseResult::Invalid;
+    }
+    const quint8 type = p[3];
+    if (type < quint8(FrameType::Probe) || type > quint8(FrameType::Exit)) {
+        return ParseResult::Invalid;
+    }
+    const int payloadSize = qFromBigEndian<quint16>(p + 4);
+    if (payloadSize > FRAME_MAX_PAYLOAD) {
+        return ParseResult::Invalid;
+    }
+    if (size < FRAME_HEADER_SIZE + payloadSize) {
+        return ParseResult::NeedMore;
+    }
+
+    frame->type = FrameType(type);
+    frame->sequence = qFromBigEndian<quint32>(p + 8);
+    frame->timestampUs = qFromBigEndian<quint64>(p + FRAME_TIMESTAMP_OFFSET);
+    frame->deviceId = qFromBigEndian<quint64>(p + 20);
+    frame->payload = payloadSize > 0 ? data + FRAME_HEADER_SIZE : nullptr;
+    frame->payloadSize = payloadSize;
+    *consumed = FRAME_HEADER_SIZE + payloadSize;
+    return ParseResult::Ok;
+}
+
+}
+
+void FrameParser::append(const QByteArray &data)
+{
+    // 旧协议不按帧消费，只保留不足一条心跳的尾部，供跨 read 拆分的心跳拼接匹配
+    if (m_legacy) {
+        const int carry = HEARTBEAT.size() - 1;
+        if (m_buffer.size() > carry) {
+            m_buffer.remove(0, m_buffer.size() - carry);
+        }
+        m_buffer.append(data);
+        return;
+    }
+    // 丢弃已消费的部分，避免缓冲区无限增长
+    if (m_offset > 0) {
+        m_buffer.remove(0, m_offset);
+        m_offset = 0;
+    }
+    m_buffer.append(data);
+
+    if (!m_checked && m_buffer.size() >= 2) {
+        m_checked = true;
+        m_legacy = !DiscoveryProtocol::looksLikeFrame(m_buffer.constData(), m_buffer.size());
+    }
+}
+
+bool FrameParser::next(Frame *frame)
+{
+    if (m_error || m_legacy) {
+        return false;
+    }
+    int consumed = 0;
+    const DiscoveryProtocol::ParseResult result = DiscoveryProtocol::parseFrame(
+        m_buffer.constData() + m_offset, m_buffer.size() - m_offset, frame, &consumed);
+    if (result == DiscoveryProtocol::ParseResult::Invalid) {
+        m_error = true;
+        return false;
+    }
+    if (result == DiscoveryProtocol::ParseResult::NeedMore) {
+        return false;
+    }
+    m_offset += consumed;
+    return true;
+}
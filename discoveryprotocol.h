@@ -0,0 +1,118 @@
+#ifndef DISCOVERYPROTOCOL_H
+#define DISCOVERYPROTOCOL_H
+
+#include <QByteArray>
+#include <QString>
+#include <QtEndian>
+
+constexpr quint16 UDP_TARGET_PORT = 9910;
+constexpr quint16 UDP_LISTEN_PORT = 68;
+constexpr quint16 TCP_LISTEN_PORT = 80;
+// 旧的纯字符串协议，仅为兼容未升级的设备保留；新探测使用下面定义的帧
+const QByteArray MESSAGE = "Hello, Device! From Finder!";
+const QByteArray SERVICE_TYPE = "_test._tcp.local.";
+const QByteArray SERVICE_NAME = "JumpWDevice";
+const QByteArray EXIT_MESSAGE = "EXIT";
+const QByteArray HEARTBEAT = "heartbeat";
+// IPv6 链路本地组播：所有节点组与本项目的组（'M''T'），设备端加入后者
+const QString IPV6_ALL_NODES = QStringLiteral("ff02::1");
+const QString IPV6_DISCOVERY_GROUP = QStringLiteral("ff02::4d54");
+
+// 发现协议帧格式（大端，28 字节帧头 + 可选负载）：
+//   0  magic     u16  'M''T'
+//   2  version   u8
+//   3  type      u8   FrameType
+//   4  length    u16  负载长度
+//   6  reserved  u16
+//   8  sequence  u32
+//  12  timestamp u64  发送方单调时钟 (us)；应答帧回显探测帧的时间戳
+//  20  deviceId  u64
+// 一个 UDP 数据报可连续携带多帧；TCP 上为连续的帧流
+constexpr quint16 FRAME_MAGIC = 0x4D54;
+constexpr quint8 FRAME_VERSION = 1;
+constexpr int FRAME_HEADER_SIZE = 28;
+constexpr int FRAME_MAX_PAYLOAD = 1024;
+constexpr int FRAME_TIMESTAMP_OFFSET = 12;
+// 在线检测心跳的序号最高位置 1，与发现探测的序号空间分开
+constexpr quint32 LIVENESS_SEQUENCE_FLAG = 0x80000000u;
+
+enum class FrameType : quint8 {
+    Probe = 1,
+    Heartbeat = 2,
+    Exit = 3,
+};
+
+// payload 指向解析缓冲区，只在回调期间（或解析器下次 append 之前）有效
+struct Frame {
+    FrameType type = FrameType::Probe;
+    quint32 sequence = 0;
+    quint64 timestampUs = 0;
+    quint64 deviceId = 0;
+    const char *payload = nullptr;
+    int payloadSize = 0;
+};
+
+namespace DiscoveryProtocol {
+
+enum class ParseResult {
+    Ok,
+    NeedMore,
+    Invalid,
+};
+
+// 把一帧追加到 out 末尾，可连续调用以在一个数据报里批量发送
+void appendFrame(QByteArray &out, const Frame &frame);
+
+QByteArray encode(const Frame &frame);
+
+// 从 data 开头解析一帧，成功时 consumed 为整帧长度
+ParseResult parseFrame(const char *data, int size, Frame *frame, int *consumed);
+
+// 数据报开头是否为帧魔数（用于区分旧的纯字符串消息）
+inline bool looksLikeFrame(const char *data, int size) {
+    return size >= 2 && qFromBigEndian<quint16>(reinterpret_cast<const uchar *>(data)) == FRAME_MAGIC;
+}
+
+// 解析一个数据报中的全部帧；返回帧数，格式错误时返回 -1
+template <typename Callback>
+int parseDatagram(const char *data, int size, Callback callback) {
+    int count = 0;
+    while (size > 0) {
+        Frame frame;
+        int consumed = 0;
+        if (parseFrame(data, size, &frame, &consumed) != ParseResult::Ok) {
+            return -1;
+        }
+        callback(frame);
+        data += consumed;
+        size -= consumed;
+        ++count;
+    }
+    return count;
+}
+
+}
+
+// TCP 流的增量解析器：处理粘包与半包
+class FrameParser {
+public:
+    void append(const QByteArray &data);
+
+    // 取出下一帧；数据不足或出错时返回 false
+    bool next(Frame *frame);
+
+    bool hasError() const { return m_error; }
+    // 流的开头不是帧魔数：对端使用旧的纯字符串协议
+    bool isLegacy() const { return m_legacy; }
+    // 旧协议：上次残留的尾部与本次数据拼接后是否包含 token
+    bool containsLegacy(const QByteArray &token) const { return m_legacy && m_buffer.contains(token); }
+
+private:
+    QByteArray m_buffer;
+    int m_offset = 0;
+    bool m_error = false;
+    bool m_legacy = false;
+    bool m_checked = false;
+};
+
+#endif // DISCOVERYPROTOCOL_H
@@ -0,0 +1,119 @@
+#include "discoverysession.h"
+#include "discoverymetrics.h"
+
+#include <QMetaMethod>
+
+DiscoverySession::DiscoverySession(const DiscoveryProfile &profile, QObject *parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<DiscoverySession::EndReason>("DiscoverySession::EndReason");
+
+    m_finder = new DeviceFinder(profile, this);
+    m_deadline = new QTimer(this);
+    m_deadline->setSingleShot(true);
+    connect(m_deadline, &QTimer::timeout, this, [this]() { finish(EndReason::Deadline); });
+
+    connect(m_finder->registry(), &DeviceRegistry::deviceAdded, this, [this](const DeviceRecord &record) {
+        if (m_state != State::Running) {
+            return;
+        }
+        emit deviceFound(record);
+        if (m_finder->isContinuous()) {
+            return;
+        }
+        if (m_finder->services()->ports().isEmpty()) {
+            finish(EndReason::DeviceFound);
+        } else {
+            // 不再探测新设备，等这台设备的服务探测结果
+            m_finder->stopDiscovery();
+        }
+    });
+    // 排在 finder 自己写入 openPorts 的连接之后，结束时的记录已带端口
+    connect(m_finder->services(), &ServiceProber::hostProbed, this, [this]() {
+        if (m_state == State::Running && !m_finder->isContinuous()) {
+            finish(EndReason::DeviceFound);
+        }
+    });
+}
+
+DiscoverySession::~DiscoverySession()
+{
+    // 运行中被释放时不再通知，只保证资源关闭
+    if (m_finder) {
+        m_finder->shutdown();
+    }
+}
+
+const char *DiscoverySession::endReasonName(EndReason reason)
+{
+    switch (reason) {
+    case EndReason::DeviceFound: return "found";
+    case EndReason::Deadline: return "deadline";
+    case EndReason::Cancelled: return "cancelled";
+    case EndReason::ListenFailed: return "listen_failed";
+    }
+    return "unknown";
+}
+
+void DiscoverySession::start()
+{
+    if (m_state != State::Idle) {
+        return;
+    }
+    m_state = State::Running;
+    m_clock.start();
+    m_finder->startListening();
+    if (!m_finder->isListening()) {
+        finish(EndReason::ListenFailed);
+        return;
+    }
+    if (m_deadlineMs > 0) {
+        m_deadline->start(m_deadlineMs);
+    }
+    m_finder->startDiscovery();
+}
+
+void DiscoverySession::cancel()
+{
+    finish(EndReason::Cancelled);
+}
+
+void DiscoverySession::finish(EndReason reason)
+{
+    if (m_state == State::Finished) {
+        return;
+    }
+    m_state = State::Finished;
+    m_deadline->stop();
+
+    // 可能处于 finder 内部的调用栈中（如 TCP 帧解析循环里发出的 deviceAdded），此时关闭监听
+    // 会释放正在使用的解析器与连接。这里只停止探测，关闭与通知延后到事件循环
+    if (m_finder) {
+        m_finder->stopDiscovery();
+        m_finder->disconnect(this);
+        m_finder->registry()->disconnect(this);
+        m_finder->services()->disconnect(this);
+    }
+    QMetaObject::invokeMethod(this, [this, reason]() {
+        DeviceFinder *finder = m_finder;
+        if (finder) {
+            finder->shutdown();
+        }
+        const DeviceRegistry *registry = finder ? finder->registry() : nullptr;
+        FINDER_TRACE() << "Discovery session ended:" << endReasonName(reason)
+                       << (registry ? registry->size() : 0) << "devices";
+        emit finishing(registry, reason);
+
+        // 只有连接了 finished 时才复制设备表
+        QVector<DeviceRecord> devices;
+        if (registry && isSignalConnected(QMetaMethod::fromSignal(&DiscoverySession::finished))) {
+            devices.reserve(registry->size());
+            registry->forEach([&devices](const DeviceRecord &record) { devices.append(record); });
+        }
+        if (finder) {
+            finder->deleteLater();
+            m_finder = nullptr;
+        }
+        emit finished(devices, reason);
+    }, Qt::QueuedConnection);
+}
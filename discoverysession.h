@@ -0,0 +1,76 @@
+#ifndef DISCOVERYSESSION_H
+#define DISCOVERYSESSION_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QVector>
+
+#include "devicefinder.h"
+
+// 一次有明确结束的发现。start() 后在以下情况之一结束，并且恰好发出一次 finished()：
+//   非持续模式找到第一台设备（开启服务探测时等该设备的端口结果）、到达期限、
+//   cancel()、监听端口绑定失败。
+// 结束时同步停止全部策略；监听、网卡与 mDNS 套接字及各定时器在回到事件循环后关闭，
+// 随后发出 finished() 并释放 finder，因此长时间运行的进程可以连续开启多次会话而不泄漏资源。
+// 每个会话只能 start() 一次
+class DiscoverySession : public QObject {
+    Q_OBJECT
+
+public:
+    enum class EndReason {
+        DeviceFound,
+        Deadline,
+        Cancelled,
+        ListenFailed,
+    };
+    Q_ENUM(EndReason)
+
+    explicit DiscoverySession(const DiscoveryProfile &profile, QObject *parent = nullptr);
+    ~DiscoverySession() override;
+
+    // 从 start() 起的最长时间，0 表示不限（只能由 cancel() 或找到设备结束）
+    void setDeadline(int ms) { m_deadlineMs = qMax(0, ms); }
+
+    // 会话运行期间的 finder，可在 start() 前做额外配置；发出 finished() 时已为空
+    DeviceFinder *finder() const { return m_finder; }
+
+    bool isRunning() const { return m_state == State::Running; }
+    bool isFinished() const { return m_state == State::Finished; }
+    qint64 elapsedMs() const { return m_clock.isValid() ? m_clock.elapsed() : 0; }
+
+    static const char *endReasonName(EndReason reason);
+
+public slots:
+    void start();
+    // 立即结束，finished() 在回到事件循环后发出；尚未开始时也会发出
+    void cancel();
+
+signals:
+    void deviceFound(const DeviceRecord &record);
+
+    // 网络资源已关闭、finder 释放之前发出，registry 为结束时的设备表（可能为空指针），
+    // 只在信号处理期间有效，须直接连接。导出等场景就地遍历，不复制整张表
+    void finishing(const DeviceRegistry *registry, DiscoverySession::EndReason reason);
+
+    // devices 为结束时设备表中的全部设备的副本；没有连接该信号时不复制
+    void finished(const QVector<DeviceRecord> &devices, DiscoverySession::EndReason reason);
+
+private:
+    enum class State {
+        Idle,
+        Running,
+        Finished,
+    };
+
+    void finish(EndReason reason);
+
+    QPointer<DeviceFinder> m_finder;
+    QTimer *m_deadline;
+    QElapsedTimer m_clock;
+    State m_state = State::Idle;
+    int m_deadlineMs = 10000;
+};
+
+#endif // DISCOVERYSESSION_H
@@ -0,0 +1,420 @@
+#include "discoverystrategies.h"
+
+#include "discoveryprotocol.h"
+#include "discoverymetrics.h"
+#include "discoverylistener.h"
+#include "networkutils.h"
+#include "neighbortable.h"
+
+// ****---------------------- Broadcast ----------------------****
+BroadcastStrategy::BroadcastStrategy(DiscoveryContext *context, QObject *parent)
+    : DiscoveryStrategy(context, parent)
+{
+    m_scheduler = new BroadcastScheduler(this);
+    connect(m_scheduler, &BroadcastScheduler::probe, this, &BroadcastStrategy::sendProbe);
+}
+
+void BroadcastStrategy::start()
+{
+    FINDER_TRACE() << "Method 1 startBroadcast";
+    m_scheduler->start();
+}
+
+void BroadcastStrategy::stop()
+{
+    m_scheduler->stop();
+}
+
+bool BroadcastStrategy::isRunning() const
+{
+    return m_scheduler->isRunning();
+}
+
+qint64 BroadcastStrategy::probeSentAtUs(quint32 ipv4) const
+{
+    Q_UNUSED(ipv4);
+    return isRunning() ? m_lastSentUs : -1;
+}
+
+void BroadcastStrategy::sendProbe()
+{
+    const QByteArray probe = m_context->makeProbe();
+    m_lastSentUs = SubnetSweeper::clockUs();
+    if (!m_address.isNull()) {
+        m_context->send(m_context->defaultSocket(), probe, m_address);
+        return;
+    }
+    const auto &sockets = m_context->interfaceSockets();
+    if (sockets.isEmpty()) {
+        m_context->send(m_context->defaultSocket(), probe, QHostAddress::Broadcast);
+        return;
+    }
+    // 每个网段发送定向广播
+    for (const auto &iface : sockets) {
+        m_context->send(iface.second, probe, iface.first.broadcast());
+    }
+}
+
+// ****---------------------- Sweep ----------------------****
+SweepStrategy::SweepStrategy(DiscoveryContext *context, QObject *parent)
+    : DiscoveryStrategy(context, parent)
+{
+    m_sweeper = new SubnetSweeper(this);
+    m_sweeper->setTimestampOffset(FRAME_TIMESTAMP_OFFSET);
+    connect(m_sweeper, &SubnetSweeper::progress, this, &SweepStrategy::progress);
+    connect(m_context->listener(), &DiscoveryListener::heartbeat, this,
+            [this](const DeviceAddress &address) {
+        if (address.isIpv4()) {
+            m_sweeper->markResponsive(address.toIpv4());
+        }
+    });
+    m_passTimer = new QTimer(this);
+    m_passTimer->setSingleShot(true);
+    connect(m_passTimer, &QTimer::timeout, this, [this]() {
+        if (m_active) {
+            startPass();
+        }
+    });
+    connect(m_sweeper, &SubnetSweeper::passFinished, this, [this]() {
+        if (!m_active) {
+            return;
+        }
+        // 两轮扫描的起始间隔不小于 1s，与原先的扫描节奏一致
+        m_passTimer->start(int(qMax<qint64>(0, 1000 - m_passClock.elapsed())));
+    });
+    // 本机网段变化时立即按新网段重新开始一轮，旧网卡套接字随后释放
+    connect(m_context, &DiscoveryContext::interfacesChanged, this, [this]() {
+        if (m_active && m_targets.isEmpty()) {
+            FINDER_TRACE() << "Interfaces changed, retargeting sweep";
+            m_passTimer->stop();
+            startPass();
+        }
+    });
+}
+
+void SweepStrategy::start()
+{
+    FINDER_TRACE() << "Method 3 startUdpScan" << m_target;
+    m_active = true;
+    m_sweeper->forgetSilent();
+    startPass();
+}
+
+void SweepStrategy::stop()
+{
+    m_active = false;
+    m_passTimer->stop();
+    m_sweeper->stop();
+}
+
+void SweepStrategy::setTarget(const QString &spec)
+{
+    m_target = spec;
+    m_targets.clear();
+    QString error;
+    m_targetValid = TargetSpec::parse(spec, &m_targets, &error);
+    if (!m_targetValid) {
+        qWarning() << error;
+    }
+}
+
+void SweepStrategy::setRange(quint32 first, quint32 last)
+{
+    m_target.clear();
+    m_targets.clear();
+    m_targets.add(first, last);
+    m_targetValid = true;
+}
+
+qint64 SweepStrategy::probeSentAtUs(quint32 ipv4) const
+{
+    return m_sweeper->sentAtUs(ipv4);
+}
+
+QVector<quint32> SweepStrategy::neighborAddresses()
+{
+    QVector<quint32> addrs;
+    const QList<Neighbor> neighbors = NeighborTable::dump(QAbstractSocket::IPv4Protocol);
+    for (const Neighbor &neighbor : neighbors) {
+        if (neighbor.isUsable()) {
+            addrs.append(neighbor.address.toIPv4Address());
+        }
+    }
+    return addrs;
+}
+
+void SweepStrategy::startPass()
+{
+    m_sweeper->clearLanes();
+
+    if (!m_targetValid || (!m_target.isEmpty() && m_targets.isEmpty())) {
+        qWarning() << "Invalid target address" << m_target;
+        m_active = false;
+        return;
+    }
+    if (!m_targets.isEmpty()) {
+        // 目标列表：合并后的每个区间一条通道，重叠的目标每轮只探测一次
+        for (const auto &range : m_targets.ranges()) {
+            m_sweeper->addLane(m_context->defaultSocket(), range.first, range.second);
+        }
+    } else {
+        // 每个网段一条通道，共享同一速率预算并行扫描
+        const auto &sockets = m_context->interfaceSockets();
+        for (const auto &iface : sockets) {
+            const quint32 ip = iface.first.ip().toIPv4Address();
+            const quint32 mask = iface.first.netmask().toIPv4Address();
+            const quint32 network = ip & mask;
+            const quint32 broadcast = network | (~mask);
+            m_sweeper->addLane(iface.second, network + 1, broadcast - 1, ip);
+        }
+
+        if (sockets.isEmpty()) {
+            QPair<QHostAddress, QHostAddress> ip_mask = m_context->interfaces()->primaryAddress();
+            QHostAddress ipAddr = ip_mask.first;
+            QHostAddress maskAddr = ip_mask.second;
+
+            if (ipAddr.isNull() || maskAddr.isNull()) {
+                qWarning() << "Failed to obtain valid network information";
+                m_active = false;
+                return;
+            }
+
+            quint32 ip = ipAddr.toIPv4Address();
+            quint32 mask = maskAddr.toIPv4Address();
+
+            quint32 network = ip & mask;
+            quint32 broadcast = network | (~mask);
+            if (broadcast - network < 2) {
+                qWarning() << "Subnet has no host addresses to scan";
+                m_active = false;
+                return;
+            }
+            m_sweeper->addLane(m_context->defaultSocket(), network + 1, broadcast - 1, ip);
+        }
+    }
+    // 每轮重新读取 ARP 表，期间新学到的邻居在下一轮最先探测
+    m_sweeper->setPriorityAddresses(neighborAddresses());
+
+    // 由 SubnetSweeper 按速率预算逐批发送，排除本机地址；时间戳在每批发送前写入
+    m_sweeper->setPayload(m_context->makeProbe(), m_context->targetPort());
+    m_passClock.start();
+    m_sweeper->start();
+}
+
+// ****---------------------- mDNS ----------------------****
+MdnsStrategy::MdnsStrategy(DiscoveryContext *context, QObject *parent)
+    : DiscoveryStrategy(context, parent)
+{
+}
+
+MdnsStrategy::~MdnsStrategy()
+{
+    stop();
+}
+
+void MdnsStrategy::start()
+{
+    if (m_server) {
+        return;
+    }
+    FINDER_TRACE() << "Method 2 startMdns";
+    m_server = new QMdnsEngine::Server(this);
+    m_hostname = new QMdnsEngine::Hostname(m_server, this);
+    m_provider = new QMdnsEngine::Provider(m_server, m_hostname, this);
+
+    const QByteArray type = SERVICE_TYPE;
+    const QByteArray name = SERVICE_NAME;
+
+    m_service.setType(type);
+    m_service.setName(name);
+    m_service.setPort(8080);
+
+    m_provider->update(m_service);
+
+    // 主动浏览 SERVICE_TYPE；Browser 会在查询中带上缓存里的 PTR 记录（已知应答抑制）
+    m_mdnsCache = new QMdnsEngine::Cache(this);
+    m_browser = new QMdnsEngine::Browser(m_server, type, m_mdnsCache, this);
+    connect(m_browser, &QMdnsEngine::Browser::serviceAdded,
+            this, &MdnsStrategy::resolveService);
+    connect(m_browser, &QMdnsEngine::Browser::serviceUpdated,
+            this, &MdnsStrategy::resolveService);
+    connect(m_browser, &QMdnsEngine::Browser::serviceRemoved,
+            this, [this](const QMdnsEngine::Service &service) {
+        QMdnsEngine::Resolver *resolver = m_resolvers.take(service.hostname());
+        if (resolver) {
+            resolver->deleteLater();
+        }
+    });
+}
+
+void MdnsStrategy::stop()
+{
+    if (!m_server) {
+        return;
+    }
+    // 可能在 Resolver 的信号中被调用，统一延后释放
+    for (QMdnsEngine::Resolver *resolver : qAsConst(m_resolvers)) {
+        resolver->deleteLater();
+    }
+    m_resolvers.clear();
+    m_browser->deleteLater();
+    m_mdnsCache->deleteLater();
+    m_provider->deleteLater();
+    m_hostname->deleteLater();
+    m_server->deleteLater();
+    m_browser = nullptr;
+    m_mdnsCache = nullptr;
+    m_provider = nullptr;
+    m_hostname = nullptr;
+    m_server = nullptr;
+}
+
+void MdnsStrategy::resolveService(const QMdnsEngine::Service &service)
+{
+    const QByteArray host = service.hostname();
+    // 跳过本机发布的服务以及已在解析中的主机
+    if (host.isEmpty() || host == m_hostname->hostname() || m_resolvers.contains(host)) {
+        return;
+    }
+    FINDER_TRACE() << "mDNS service" << service.name() << "on" << host;
+
+    // Resolver 先查缓存中的 A/AAAA 记录，缺失时才发出查询
+    QMdnsEngine::Resolver *resolver = new QMdnsEngine::Resolver(m_server, host, m_mdnsCache, this);
+    connect(resolver, &QMdnsEngine::Resolver::resolved, this, [this](const QHostAddress &address) {
+        if (address.protocol() == QAbstractSocket::IPv4Protocol) {
+            emit deviceResolved(address);
+        }
+    });
+    m_resolvers.insert(host, resolver);
+}
+
+// ****---------------------- IPv6 ----------------------****
+Ipv6Strategy::Ipv6Strategy(DiscoveryContext *context, QObject *parent)
+    : DiscoveryStrategy(context, parent)
+{
+    m_scheduler = new BroadcastScheduler(this);
+    connect(m_scheduler, &BroadcastScheduler::probe, this, &Ipv6Strategy::sendProbe);
+}
+
+void Ipv6Strategy::start()
+{
+    FINDER_TRACE() << "Method 4 startIpv6";
+    m_scheduler->start();
+}
+
+void Ipv6Strategy::stop()
+{
+    m_scheduler->stop();
+    m_probed.clear();
+    m_lastMulticastUs = -1;
+}
+
+bool Ipv6Strategy::isRunning() const
+{
+    return m_scheduler->isRunning();
+}
+
+qint64 Ipv6Strategy::probeSentAt(const DeviceAddress &address) const
+{
+    if (address.isIpv4() || !isRunning()) {
+        return -1;
+    }
+    // 邻居单播优先，其余应答归于最近一次组播
+    return m_probed.value(address, m_lastMulticastUs);
+}
+
+void Ipv6Strategy::sendProbe()
+{
+    QUdpSocket *socket = m_context->defaultSocket();
+    const QByteArray probe = m_context->makeProbe();
+    // 只保留上一轮的探测时刻供迟到的应答归因，更早的（含已消失的邻居）丢弃
+    for (auto it = m_probed.begin(); it != m_probed.end();) {
+        if (it.value() < m_lastMulticastUs) {
+            it = m_probed.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    m_lastMulticastUs = SubnetSweeper::clockUs();
+
+    // 链路本地组播必须指定接口：每个支持组播且有 IPv6 地址的网卡各发一次
+    foreach (int index, m_context->interfaces()->ipv6Interfaces()) {
+        const QString scope = QString::number(index);
+        for (const QString &group : {IPV6_ALL_NODES, IPV6_DISCOVERY_GROUP}) {
+            QHostAddress destination(group);
+            destination.setScopeId(scope);
+            m_context->send(socket, probe, destination);
+        }
+    }
+
+    // 内核已解析过的邻居直接单播，不依赖设备响应组播
+    const qint64 now = SubnetSweeper::clockUs();
+    for (const Neighbor &neighbor : NeighborTable::dump(QAbstractSocket::IPv6Protocol)) {
+        if (!neighbor.isUsable() || neighbor.address.isMulticast()) {
+            continue;
+        }
+        m_probed.insert(DeviceAddress::fromHostAddress(neighbor.address), now);
+        m_context->send(socket, probe, neighbor.address);
+    }
+}
+
+// ****---------------------- Cache ----------------------****
+CacheStrategy::CacheStrategy(DiscoveryContext *context, QObject *parent)
+    : DiscoveryStrategy(context, parent)
+{
+    m_graceTimer = new QTimer(this);
+    m_graceTimer->setSingleShot(true);
+    m_graceTimer->setInterval(300);
+    connect(m_graceTimer, &QTimer::timeout, this, [this]() {
+        // 等待期结束后的应答不再归因于缓存探测
+        m_probed.clear();
+        emit graceExpired();
+    });
+
+    // 合并短时间内的多次写入
+    m_saveTimer = new QTimer(this);
+    m_saveTimer->setSingleShot(true);
+    m_saveTimer->setInterval(1000);
+    connect(m_saveTimer, &QTimer::timeout, this, [this]() {
+        m_cache.save();
+    });
+}
+
+CacheStrategy::~CacheStrategy()
+{
+    if (m_cache.isDirty()) {
+        m_cache.save();
+    }
+}
+
+bool CacheStrategy::hasCandidates()
+{
+    return m_cache.load() && !m_cache.isEmpty();
+}
+
+void CacheStrategy::start()
+{
+    const QList<CachedDevice> cached = m_cache.devices();
+    FINDER_TRACE() << "Probing" << cached.size() << "cached devices";
+
+    QUdpSocket *socket = m_context->defaultSocket();
+    for (const CachedDevice &device : cached) {
+        m_probed.insert(device.ipv4, SubnetSweeper::clockUs());
+        m_context->send(socket, m_context->makeProbe(), QHostAddress(device.ipv4));
+    }
+    m_graceTimer->start();
+}
+
+void CacheStrategy::stop()
+{
+    m_graceTimer->stop();
+    m_probed.clear();
+}
+
+void CacheStrategy::record(const QHostAddress &address, DiscoveryMethod method)
+{
+    m_cache.record(address, method, NetworkUtils::macForAddress(address));
+    if (!m_saveTimer->isActive()) {
+        m_saveTimer->start();
+    }
+}
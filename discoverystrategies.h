@@ -0,0 +1,175 @@
+#ifndef DISCOVERYSTRATEGIES_H
+#define DISCOVERYSTRATEGIES_H
+
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QHash>
+
+#include <qmdnsengine/server.h>
+#include <qmdnsengine/provider.h>
+#include <qmdnsengine/hostname.h>
+#include <qmdnsengine/service.h>
+#include <qmdnsengine/browser.h>
+#include <qmdnsengine/cache.h>
+#include <qmdnsengine/resolver.h>
+
+#include "discoverystrategy.h"
+#include "broadcastscheduler.h"
+#include "subnetsweeper.h"
+#include "targetspec.h"
+#include "devicecache.h"
+
+// 向每个网段发送定向广播，间隔指数退避
+class BroadcastStrategy : public DiscoveryStrategy {
+    Q_OBJECT
+
+public:
+    explicit BroadcastStrategy(DiscoveryContext *context, QObject *parent = nullptr);
+
+    DiscoveryMethod method() const override { return DiscoveryMethod::Broadcast; }
+    void start() override;
+    void stop() override;
+    bool isRunning() const override;
+    // 广播覆盖整个网段，进行中时任何应答都归于最近一次广播
+    qint64 probeSentAtUs(quint32 ipv4) const override;
+
+    BroadcastScheduler *scheduler() const { return m_scheduler; }
+
+    // 只向该地址发送广播（经默认套接字），不再按网卡网段发送；空地址恢复默认
+    void setBroadcastAddress(const QHostAddress &address) { m_address = address; }
+
+private:
+    void sendProbe();
+
+    BroadcastScheduler *m_scheduler;
+    QHostAddress m_address;
+    qint64 m_lastSentUs = -1;
+};
+
+// 按速率预算逐个单播探测各网段内的地址；设置了目标列表时只探测列表中的地址。
+// 每轮先探测内核 ARP 表中的主机与提示网段，再探测其余地址。
+// 一轮结束后间隔不小于 1s 开始下一轮，直到 stop()
+class SweepStrategy : public DiscoveryStrategy {
+    Q_OBJECT
+
+public:
+    explicit SweepStrategy(DiscoveryContext *context, QObject *parent = nullptr);
+
+    DiscoveryMethod method() const override { return DiscoveryMethod::UnicastScan; }
+    void start() override;
+    void stop() override;
+    bool isRunning() const override { return m_active; }
+    qint64 probeSentAtUs(quint32 ipv4) const override;
+
+    // 目标列表（见 TargetSpec::parse），合并去重后每个区间一条通道
+    void setTarget(const QString &spec);
+
+    // 扫描指定的闭区间 [first, last]（经默认套接字），不再按网卡网段扫描
+    void setRange(quint32 first, quint32 last);
+
+    void setRate(int packetsPerSecond) { m_sweeper->setRate(packetsPerSecond); }
+
+    // 优先探测的闭区间（如 DHCP 地址池）
+    void setHintRanges(const QVector<QPair<quint32, quint32>> &ranges) { m_sweeper->setHintRanges(ranges); }
+
+    SubnetSweeper *sweeper() const { return m_sweeper; }
+
+private:
+    void startPass();
+
+    // 内核 ARP 表中可达的 IPv4 邻居
+    static QVector<quint32> neighborAddresses();
+
+    SubnetSweeper *m_sweeper;
+    QTimer *m_passTimer;
+    QElapsedTimer m_passClock;
+    QString m_target;
+    IntervalSet m_targets;
+    bool m_targetValid = true;
+    bool m_active = false;
+};
+
+// 发布本机服务并浏览 SERVICE_TYPE，解析出的 IPv4 地址直接上报
+class MdnsStrategy : public DiscoveryStrategy {
+    Q_OBJECT
+
+public:
+    explicit MdnsStrategy(DiscoveryContext *context, QObject *parent = nullptr);
+    ~MdnsStrategy() override;
+
+    DiscoveryMethod method() const override { return DiscoveryMethod::Mdns; }
+    void start() override;
+    void stop() override;
+    bool isRunning() const override { return m_server != nullptr; }
+
+private:
+    void resolveService(const QMdnsEngine::Service &service);
+
+    QMdnsEngine::Server *m_server = nullptr;
+    QMdnsEngine::Hostname *m_hostname = nullptr;
+    QMdnsEngine::Provider *m_provider = nullptr;
+    QMdnsEngine::Service m_service;
+    // 按 TTL 过期的应答缓存，浏览查询时附带已知应答
+    QMdnsEngine::Cache *m_mdnsCache = nullptr;
+    QMdnsEngine::Browser *m_browser = nullptr;
+    QHash<QByteArray, QMdnsEngine::Resolver *> m_resolvers;
+};
+
+// IPv6 网段无法逐地址扫描：每个网卡向 ff02::1 与项目组播组发送探测，
+// 并单播探测内核 NDP 邻居表中的地址；轮次间隔沿用广播的指数退避
+class Ipv6Strategy : public DiscoveryStrategy {
+    Q_OBJECT
+
+public:
+    explicit Ipv6Strategy(DiscoveryContext *context, QObject *parent = nullptr);
+
+    DiscoveryMethod method() const override { return DiscoveryMethod::Ipv6; }
+    void start() override;
+    void stop() override;
+    bool isRunning() const override;
+    qint64 probeSentAt(const DeviceAddress &address) const override;
+
+    BroadcastScheduler *scheduler() const { return m_scheduler; }
+
+private:
+    void sendProbe();
+
+    BroadcastScheduler *m_scheduler;
+    QHash<DeviceAddress, qint64> m_probed;  // NDP 邻居 -> 单播探测时刻 (us)，只保留最近两轮
+    qint64 m_lastMulticastUs = -1;
+};
+
+// 单播探测上次运行时发现的设备，宽限期结束后发出 graceExpired
+class CacheStrategy : public DiscoveryStrategy {
+    Q_OBJECT
+
+public:
+    explicit CacheStrategy(DiscoveryContext *context, QObject *parent = nullptr);
+    ~CacheStrategy() override;
+
+    DiscoveryMethod method() const override { return DiscoveryMethod::Cache; }
+    void start() override;
+    void stop() override;
+    bool isRunning() const override { return m_graceTimer->isActive(); }
+    qint64 probeSentAtUs(quint32 ipv4) const override { return m_probed.value(ipv4, -1); }
+
+    // 缓存地址探测后等待应答的时间
+    void setGracePeriod(int ms) { m_graceTimer->setInterval(ms); }
+
+    // 读取缓存文件，有可探测的地址时返回 true
+    bool hasCandidates();
+
+    // 记录发现的设备，短时间内的多次写入合并为一次保存
+    void record(const QHostAddress &address, DiscoveryMethod method);
+
+signals:
+    void graceExpired();
+
+private:
+    DeviceCache m_cache;
+    QHash<quint32, qint64> m_probed;    // 地址 -> 探测发送时刻 (us)
+    QTimer *m_graceTimer;
+    QTimer *m_saveTimer;
+};
+
+#endif // DISCOVERYSTRATEGIES_H
@@ -0,0 +1,137 @@
+#include "discoverystrategy.h"
+
+#include "discoverycapture.h"
+#include "discoverylistener.h"
+#include "discoverymetrics.h"
+#include "discoveryprotocol.h"
+#include "subnetsweeper.h"
+
+#include <algorithm>
+
+DiscoveryContext::DiscoveryContext(DiscoveryListener *listener, quint16 targetPort, QObject *parent)
+    : QObject(parent)
+    , m_listener(listener)
+    , m_targetPort(targetPort)
+{
+    m_interfaces = new InterfaceMonitor(this);
+    connect(m_interfaces, &InterfaceMonitor::changed, this, &DiscoveryContext::onInterfacesChanged);
+    m_subnets = m_interfaces->subnets();
+}
+
+QUdpSocket *DiscoveryContext::defaultSocket() const
+{
+    return m_listener->udpSocket();
+}
+
+const QList<QPair<QNetworkAddressEntry, QUdpSocket *>> &DiscoveryContext::interfaceSockets()
+{
+    if (!m_ifaceSockets.isEmpty()) {
+        return m_ifaceSockets;
+    }
+    foreach (const QNetworkAddressEntry &entry, m_interfaces->subnets()) {
+        if (QUdpSocket *socket = openInterfaceSocket(entry)) {
+            m_ifaceSockets.append(qMakePair(entry, socket));
+        }
+    }
+    return m_ifaceSockets;
+}
+
+QUdpSocket *DiscoveryContext::openInterfaceSocket(const QNetworkAddressEntry &entry)
+{
+    QUdpSocket *socket = new QUdpSocket(this);
+    if (!socket->bind(entry.ip(), 0)) {
+        qWarning() << "Failed to bind" << entry.ip() << socket->errorString();
+        socket->deleteLater();
+        return nullptr;
+    }
+    socket->setSocketOption(QAbstractSocket::MulticastLoopbackOption, 1);
+    m_listener->attach(socket);
+    FINDER_TRACE() << "Interface socket" << entry.ip() << "/" << entry.prefixLength();
+    return socket;
+}
+
+void DiscoveryContext::releaseSockets()
+{
+    for (const auto &iface : qAsConst(m_ifaceSockets)) {
+        DiscoveryListener::detach(iface.second);
+        iface.second->close();
+        iface.second->deleteLater();
+    }
+    m_ifaceSockets.clear();
+}
+
+void DiscoveryContext::onInterfacesChanged()
+{
+    auto sameSubnet = [](const QNetworkAddressEntry &a, const QNetworkAddressEntry &b) {
+        return a.ip() == b.ip() && a.prefixLength() == b.prefixLength();
+    };
+    // 只关心 IPv4 网段；IPv6 地址或网卡标志的变化不影响扫描
+    const QList<QNetworkAddressEntry> subnets = m_interfaces->subnets();
+    if (std::equal(subnets.cbegin(), subnets.cend(), m_subnets.cbegin(), m_subnets.cend(), sameSubnet)) {
+        return;
+    }
+    m_subnets = subnets;
+
+    // 保留仍存在的网段的套接字，关闭消失的，为新增的打开；
+    // 尚未打开过套接字时下次 interfaceSockets() 按新快照打开
+    QList<QPair<QNetworkAddressEntry, QUdpSocket *>> kept;
+    QList<QUdpSocket *> removed;
+    for (const auto &iface : m_ifaceSockets) {
+        const bool present = std::any_of(subnets.cbegin(), subnets.cend(),
+                                         [&](const QNetworkAddressEntry &entry) {
+            return sameSubnet(entry, iface.first);
+        });
+        if (present) {
+            kept.append(iface);
+        } else {
+            FINDER_TRACE() << "Interface address gone" << iface.first.ip();
+            removed.append(iface.second);
+        }
+    }
+    if (!m_ifaceSockets.isEmpty()) {
+        for (const QNetworkAddressEntry &entry : subnets) {
+            const bool known = std::any_of(kept.cbegin(), kept.cend(),
+                                           [&](const QPair<QNetworkAddressEntry, QUdpSocket *> &iface) {
+                return sameSubnet(entry, iface.first);
+            });
+            if (known) {
+                continue;
+            }
+            if (QUdpSocket *socket = openInterfaceSocket(entry)) {
+                kept.append(qMakePair(entry, socket));
+            }
+        }
+    }
+    m_ifaceSockets = kept;
+
+    emit interfacesChanged();
+    // 使用者已在 interfacesChanged() 中放弃旧套接字，这里再释放
+    for (QUdpSocket *socket : removed) {
+        DiscoveryListener::detach(socket);
+        socket->deleteLater();
+    }
+}
+
+bool DiscoveryContext::send(QUdpSocket *socket, const QByteArray &probe, const QHostAddress &address)
+{
+    if (socket->writeDatagram(probe, address, m_targetPort) < 0) {
+        countMetric(MetricCounter::SendErrors);
+        FINDER_TRACE() << "Probe to" << address << "failed:" << socket->errorString();
+        return false;
+    }
+    countMetric(MetricCounter::ProbesSent);
+    if (CaptureWriter *capture = CaptureWriter::active()) {
+        capture->append(CaptureKind::ProbeSent, DeviceAddress::fromHostAddress(address), m_targetPort,
+                        probe.constData(), probe.size());
+    }
+    return true;
+}
+
+QByteArray DiscoveryContext::makeProbe()
+{
+    Frame frame;
+    frame.type = FrameType::Probe;
+    frame.sequence = ++m_sequence & ~LIVENESS_SEQUENCE_FLAG;
+    frame.timestampUs = quint64(SubnetSweeper::clockUs());
+    return DiscoveryProtocol::encode(frame);
+}
@@ -0,0 +1,98 @@
+#ifndef DISCOVERYSTRATEGY_H
+#define DISCOVERYSTRATEGY_H
+
+#include <QObject>
+#include <QUdpSocket>
+#include <QHostAddress>
+#include <QNetworkAddressEntry>
+#include <QList>
+#include <QPair>
+
+#include "devicecache.h"
+#include "deviceaddress.h"
+#include "interfacemonitor.h"
+
+class DiscoveryListener;
+
+// 各发现策略共享的发送资源：默认套接字、每网卡套接字、探测帧序号
+class DiscoveryContext : public QObject {
+    Q_OBJECT
+
+public:
+    DiscoveryContext(DiscoveryListener *listener, quint16 targetPort, QObject *parent = nullptr);
+
+    quint16 targetPort() const { return m_targetPort; }
+    void setTargetPort(quint16 port) { m_targetPort = port; }
+
+    DiscoveryListener *listener() const { return m_listener; }
+
+    // 缓存的网卡快照，地址变化时更新
+    InterfaceMonitor *interfaces() const { return m_interfaces; }
+
+    // 监听端口上的套接字，网卡套接字不可用时的发送后备
+    QUdpSocket *defaultSocket() const;
+
+    // 每个网段一个绑定到该网卡地址的套接字，首次调用时打开；
+    // 设备可能直接回复探测包的源端口，因此都挂到共享监听上。
+    // 网段变化时随之增删，已移除的套接字在 interfacesChanged() 之后才释放
+    const QList<QPair<QNetworkAddressEntry, QUdpSocket *>> &interfaceSockets();
+
+    // 关闭并释放全部网卡套接字；之后再调用 interfaceSockets() 会重新打开
+    void releaseSockets();
+
+    // 新的探测帧，带递增序号与发送时刻
+    QByteArray makeProbe();
+
+    // 把探测包发到 address 的目标端口，并计入发送指标
+    bool send(QUdpSocket *socket, const QByteArray &probe, const QHostAddress &address);
+
+signals:
+    // 本机 IPv4 网段有增删（DHCP 续租、换线等），扫描应按新网段重新开始
+    void interfacesChanged();
+
+private:
+    void onInterfacesChanged();
+    QUdpSocket *openInterfaceSocket(const QNetworkAddressEntry &entry);
+
+    DiscoveryListener *m_listener;
+    InterfaceMonitor *m_interfaces;
+    QList<QNetworkAddressEntry> m_subnets;  // 最近一次通知时的 IPv4 网段
+    QList<QPair<QNetworkAddressEntry, QUdpSocket *>> m_ifaceSockets;
+    quint16 m_targetPort;
+    quint32 m_sequence = 0;
+};
+
+// 一种发现方式。探测类策略只负责发包，应答由共享监听统一接收；
+// 能直接得出设备地址的策略（如 mDNS）通过 deviceResolved 上报。
+class DiscoveryStrategy : public QObject {
+    Q_OBJECT
+
+public:
+    explicit DiscoveryStrategy(DiscoveryContext *context, QObject *parent = nullptr)
+        : QObject(parent), m_context(context) {}
+
+    virtual DiscoveryMethod method() const = 0;
+
+    virtual void start() = 0;
+    virtual void stop() = 0;
+    virtual bool isRunning() const = 0;
+
+    // 本策略最近一次向 ipv4 发出探测的时刻（SubnetSweeper::clockUs），
+    // 未探测该地址时返回 -1；用于归类应答并估算 RTT
+    virtual qint64 probeSentAtUs(quint32 ipv4) const { Q_UNUSED(ipv4); return -1; }
+
+    // 同上，适用于 IPv4 与 IPv6 地址；IPv4 默认转交 probeSentAtUs
+    virtual qint64 probeSentAt(const DeviceAddress &address) const {
+        return address.isIpv4() ? probeSentAtUs(address.toIpv4()) : -1;
+    }
+
+signals:
+    void deviceResolved(const QHostAddress &address);
+
+    void progress(quint64 sent, quint64 total);
+
+protected:
+    DiscoveryContext *m_context;
+};
+
+#endif // DISCOVERYSTRATEGY_H
@@ -0,0 +1,406 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QtEndian>
+
+#include "devicefinder.h"
+#include "discoverymetrics.h"
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+// 发现基准：在 127.1.0.0/16 回环地址上模拟 N 台设备，逐个测量各发现方式。
+// 模拟设备在一个子进程中运行，只用一个 IP_PKTINFO 套接字，按目的地址
+// 以对应设备的地址为源地址应答；被测的 DeviceFinder 在另一个子进程中运行，
+// CPU 时间与峰值 RSS 取自 wait4() 返回的该子进程 rusage。
+// 每种方式输出一行 JSON；退出码：0 全部找到，1 有方式未找全，2 参数或环境错误
+
+constexpr quint32 FLEET_FIRST = 0x7F010001;        // 127.1.0.1
+constexpr quint32 FLEET_BROADCAST = 0x7FFFFFFF;    // 127.255.255.255
+constexpr int FLEET_MAX_DEVICES = 10000;
+constexpr int FLEET_BUFFER_SIZE = 8 << 20;
+
+struct FleetCounters {
+    quint64 received = 0;   // 收到的数据报（探测与 EXIT 应答）
+    quint64 probes = 0;     // 其中的探测帧与旧协议消息
+    quint64 replies = 0;    // 模拟设备发出的心跳
+};
+
+struct FinderResult {
+    qint64 firstUs = -1;    // 第一台设备出现
+    qint64 allUs = -1;      // 全部设备出现
+    int found = 0;
+    quint64 probesSent = 0; // 被测进程发出的探测包（DiscoveryMetrics ProbesSent）
+};
+
+static QTextStream &out()
+{
+    static QTextStream stream(stdout);
+    return stream;
+}
+
+static bool readFully(int fd, void *data, size_t size)
+{
+    char *p = static_cast<char *>(data);
+    while (size > 0) {
+        const ssize_t n = read(fd, p, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= size_t(n);
+    }
+    return true;
+}
+
+static bool writeFully(int fd, const void *data, size_t size)
+{
+    const char *p = static_cast<const char *>(data);
+    while (size > 0) {
+        const ssize_t n = write(fd, p, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= size_t(n);
+    }
+    return true;
+}
+
+// 以 source 为源地址把 reply 发回 peer
+static bool sendFrom(int fd, quint32 source, const sockaddr_in &peer, const QByteArray &reply)
+{
+    iovec iov;
+    iov.iov_base = const_cast<char *>(reply.constData());
+    iov.iov_len = size_t(reply.size());
+
+    char control[CMSG_SPACE(sizeof(in_pktinfo))];
+    memset(control, 0, sizeof(control));
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = const_cast<sockaddr_in *>(&peer);
+    msg.msg_namelen = sizeof(peer);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = IPPROTO_IP;
+    cmsg->cmsg_type = IP_PKTINFO;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(in_pktinfo));
+    in_pktinfo *info = reinterpret_cast<in_pktinfo *>(CMSG_DATA(cmsg));
+    info->ipi_spec_dst.s_addr = htonl(source);
+
+    return sendmsg(fd, &msg, 0) >= 0;
+}
+
+// 模拟设备进程：与 ConnectionHandler 相同的应答规则。控制管道关闭后
+// 把计数写入 resultFd 并退出；绑定完成后先写一个字节通知父进程
+static int runFleet(int count, quint16 port, int controlFd, int resultFd)
+{
+    const int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    const int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    setsockopt(fd, IPPROTO_IP, IP_PKTINFO, &on, sizeof(on));
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &FLEET_BUFFER_SIZE, sizeof(FLEET_BUFFER_SIZE));
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &FLEET_BUFFER_SIZE, sizeof(FLEET_BUFFER_SIZE));
+
+    sockaddr_in local;
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(port);
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr *>(&local), sizeof(local)) < 0) {
+        return 2;
+    }
+    const char ready = 'R';
+    writeFully(resultFd, &ready, 1);
+
+    FleetCounters counters;
+    char buffer[2048];
+    char control[CMSG_SPACE(sizeof(in_pktinfo))];
+    QByteArray reply;
+    reply.reserve(FRAME_HEADER_SIZE * 8);
+
+    pollfd fds[2] = {{fd, POLLIN, 0}, {controlFd, POLLIN, 0}};
+    while (true) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (fds[1].revents) {
+            break;
+        }
+        if (!(fds[0].revents & POLLIN)) {
+            continue;
+        }
+
+        sockaddr_in peer;
+        iovec iov = {buffer, sizeof(buffer)};
+        msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_name = &peer;
+        msg.msg_namelen = sizeof(peer);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        const ssize_t size = recvmsg(fd, &msg, 0);
+        if (size < 0) {
+            continue;
+        }
+        ++counters.received;
+
+        quint32 destination = 0;
+        for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_PKTINFO) {
+                destination = ntohl(reinterpret_cast<in_pktinfo *>(CMSG_DATA(cmsg))->ipi_addr.s_addr);
+            }
+        }
+
+        // 广播由全部设备应答，单播只由目的地址对应的设备应答
+        quint32 first = FLEET_FIRST;
+        quint32 last = FLEET_FIRST + quint32(count) - 1;
+        if (destination != FLEET_BROADCAST) {
+            if (destination < first || destination > last) {
+                continue;
+            }
+            first = last = destination;
+        }
+
+        const bool framed = DiscoveryProtocol::looksLikeFrame(buffer, int(size));
+        if (!framed) {
+            const QByteArray text(buffer, int(size));
+            if (text != MESSAGE && text != HEARTBEAT) {
+                continue;
+            }
+            ++counters.probes;
+            for (quint32 device = first; device <= last; ++device) {
+                counters.replies += sendFrom(fd, device, peer, HEARTBEAT);
+            }
+            continue;
+        }
+
+        for (quint32 device = first; device <= last; ++device) {
+            reply.resize(0);
+            DiscoveryProtocol::parseDatagram(buffer, int(size), [&](const Frame &frame) {
+                if (frame.type != FrameType::Probe && frame.type != FrameType::Heartbeat) {
+                    return;
+                }
+                Frame heartbeat;
+                heartbeat.type = FrameType::Heartbeat;
+                heartbeat.sequence = frame.sequence;
+                heartbeat.timestampUs = frame.timestampUs;
+                heartbeat.deviceId = device - FLEET_FIRST + 1;
+                DiscoveryProtocol::appendFrame(reply, heartbeat);
+            });
+            if (reply.isEmpty()) {
+                break;      // EXIT 等无需应答的帧
+            }
+            if (device == first) {
+                ++counters.probes;
+            }
+            counters.replies += sendFrom(fd, device, peer, reply);
+        }
+    }
+
+    writeFully(resultFd, &counters, sizeof(counters));
+    close(fd);
+    return 0;
+}
+
+// 被测进程：只启用 method 对应的策略，持续发现直到全部设备出现或超时
+static int runFinder(int argc, char *argv[], const QString &method, int count,
+                     quint16 port, int rate, int timeoutMs, int resultFd)
+{
+    QCoreApplication app(argc, argv);
+
+    // 监听端口为 0：由系统分配，无需特权端口
+    DeviceFinder finder(QVector<bool>(3, false), QString(), 0, 0, port);
+    finder.setCacheEnabled(false);
+    finder.setContinuous(true);
+
+    if (method == QLatin1String("broadcast")) {
+        BroadcastStrategy *broadcast = new BroadcastStrategy(finder.context());
+        broadcast->setBroadcastAddress(QHostAddress(FLEET_BROADCAST));
+        finder.addStrategy(broadcast);
+    } else {
+        SweepStrategy *sweep = new SweepStrategy(finder.context());
+        sweep->setRange(FLEET_FIRST, FLEET_FIRST + quint32(count) - 1);
+        sweep->setRate(rate);
+        finder.addStrategy(sweep);
+    }
+
+    FinderResult result;
+    QElapsedTimer clock;
+    QObject::connect(finder.registry(), &DeviceRegistry::deviceAdded, &app, [&]() {
+        ++result.found;
+        if (result.firstUs < 0) {
+            result.firstUs = clock.nsecsElapsed() / 1000;
+        }
+        if (result.found >= count) {
+            result.allUs = clock.nsecsElapsed() / 1000;
+            finder.stopDiscovery();
+            app.exit(0);
+        }
+    });
+    QTimer::singleShot(timeoutMs, &app, [&]() {
+        finder.stopDiscovery();
+        app.exit(1);
+    });
+    QTimer::singleShot(0, &finder, [&]() {
+        finder.startListening();
+        clock.start();
+        finder.startDiscovery();
+    });
+
+    const int code = app.exec();
+    result.probesSent = DiscoveryMetrics::instance().snapshot().value(MetricCounter::ProbesSent);
+    writeFully(resultFd, &result, sizeof(result));
+    return code;
+}
+
+static double toMs(const timeval &tv)
+{
+    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+int main(int argc, char *argv[])
+{
+    // 子进程各自创建 QCoreApplication，父进程只解析参数，不创建应用对象
+    QStringList arguments;
+    for (int i = 0; i < argc; ++i) {
+        arguments.append(QString::fromLocal8Bit(argv[i]));
+    }
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Discovery benchmark against a simulated loopback fleet"));
+    QCommandLineOption devicesOption(QStringList{"n", "devices"},
+        QStringLiteral("Number of simulated devices (1-10000)."), QStringLiteral("count"),
+        QStringLiteral("1000"));
+    QCommandLineOption methodsOption(QStringList{"m", "methods"},
+        QStringLiteral("Comma separated methods to measure: broadcast, scan."),
+        QStringLiteral("list"), QStringLiteral("broadcast,scan"));
+    QCommandLineOption portOption(QStringLiteral("port"),
+        QStringLiteral("UDP port the simulated devices listen on."), QStringLiteral("port"),
+        QStringLiteral("19910"));
+    QCommandLineOption rateOption(QStringList{"r", "rate"},
+        QStringLiteral("Sweep budget in packets per second."), QStringLiteral("pps"),
+        QStringLiteral("10000"));
+    QCommandLineOption timeoutOption(QStringLiteral("timeout"),
+        QStringLiteral("Per-method limit in milliseconds."), QStringLiteral("ms"),
+        QStringLiteral("30000"));
+    parser.addOptions({devicesOption, methodsOption, portOption, rateOption, timeoutOption});
+    if (!parser.parse(arguments)) {
+        qCritical() << parser.errorText();
+        return 2;
+    }
+
+    const int count = parser.value(devicesOption).toInt();
+    const quint16 port = quint16(parser.value(portOption).toUInt());
+    const int rate = parser.value(rateOption).toInt();
+    const int timeoutMs = parser.value(timeoutOption).toInt();
+    const QStringList methods = parser.value(methodsOption).split(',', Qt::SkipEmptyParts);
+    if (count < 1 || count > FLEET_MAX_DEVICES || port == 0 || rate <= 0 || timeoutMs <= 0) {
+        qCritical() << "Invalid arguments";
+        return 2;
+    }
+    for (const QString &method : methods) {
+        if (method != QLatin1String("broadcast") && method != QLatin1String("scan")) {
+            qCritical() << "Unsupported method:" << method;
+            return 2;
+        }
+    }
+
+    int exitCode = 0;
+    for (const QString &method : methods) {
+        int control[2];
+        int fleetResult[2];
+        int finderResult[2];
+        if (pipe(control) < 0 || pipe(fleetResult) < 0 || pipe(finderResult) < 0) {
+            qCritical() << "pipe:" << strerror(errno);
+            return 2;
+        }
+        out().flush();
+
+        const pid_t fleetPid = fork();
+        if (fleetPid == 0) {
+            close(control[1]);
+            close(fleetResult[0]);
+            close(finderResult[0]);
+            close(finderResult[1]);
+            _exit(runFleet(count, port, control[0], fleetResult[1]));
+        }
+        close(control[0]);
+        close(fleetResult[1]);
+        char ready = 0;
+        if (fleetPid < 0 || !readFully(fleetResult[0], &ready, 1)) {
+            qCritical() << "Simulated fleet failed to bind port" << port;
+            return 2;
+        }
+
+        const pid_t finderPid = fork();
+        if (finderPid == 0) {
+            close(control[1]);
+            close(fleetResult[0]);
+            close(finderResult[0]);
+            _exit(runFinder(argc, argv, method, count, port, rate, timeoutMs, finderResult[1]));
+        }
+        close(finderResult[1]);
+
+        int status = 0;
+        rusage usage;
+        memset(&usage, 0, sizeof(usage));
+        wait4(finderPid, &status, 0, &usage);
+        FinderResult result;
+        readFully(finderResult[0], &result, sizeof(result));
+        close(finderResult[0]);
+
+        // 关闭控制管道让模拟设备退出并交回计数
+        close(control[1]);
+        FleetCounters counters;
+        readFully(fleetResult[0], &counters, sizeof(counters));
+        close(fleetResult[0]);
+        waitpid(fleetPid, nullptr, 0);
+
+        QJsonObject object;
+        object.insert(QStringLiteral("method"), method);
+        object.insert(QStringLiteral("devices"), count);
+        object.insert(QStringLiteral("found"), result.found);
+        object.insert(QStringLiteral("first_ms"), result.firstUs < 0 ? -1.0 : result.firstUs / 1000.0);
+        object.insert(QStringLiteral("all_ms"), result.allUs < 0 ? -1.0 : result.allUs / 1000.0);
+        object.insert(QStringLiteral("packets_sent"), double(result.probesSent));
+        object.insert(QStringLiteral("probes"), double(counters.probes));
+        object.insert(QStringLiteral("replies"), double(counters.replies));
+        object.insert(QStringLiteral("cpu_user_ms"), toMs(usage.ru_utime));
+        object.insert(QStringLiteral("cpu_sys_ms"), toMs(usage.ru_stime));
+        object.insert(QStringLiteral("peak_rss_kb"), double(usage.ru_maxrss));
+        out() << QJsonDocument(object).toJson(QJsonDocument::Compact) << '\n';
+        out().flush();
+
+        if (result.found < count) {
+            exitCode = 1;
+        }
+    }
+    return exitCode;
+}
@@ -0,0 +1,310 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include "devicefinder.h"
+#include "discoverysession.h"
+#include "deviceexport.h"
+#include "discoverymetrics.h"
+#include "metricsexporter.h"
+#include "targetspec.h"
+
+#include <climits>
+
+// 无界面发现工具：参数来自命令行，每个事件输出一行 JSON 到标准输出
+// 退出码：0 找到设备，1 超时未找到，2 参数错误或监听端口绑定失败
+
+static QTextStream &out()
+{
+    static QTextStream stream(stdout);
+    return stream;
+}
+
+static void emitJson(const QJsonObject &object)
+{
+    out() << QJsonDocument(object).toJson(QJsonDocument::Compact) << '\n';
+    out().flush();
+}
+
+static QJsonObject recordJson(const char *event, const DeviceRecord &record, qint64 elapsedMs)
+{
+    QJsonObject object;
+    object.insert(QStringLiteral("event"), QLatin1String(event));
+    object.insert(QStringLiteral("ip"), record.address.toHostAddress().toString());
+    object.insert(QStringLiteral("method"), QLatin1String(discoveryMethodName(record.method)));
+    object.insert(QStringLiteral("rtt_us"), double(record.rttUs));
+    object.insert(QStringLiteral("device_id"), deviceIdText(record.deviceId));
+    object.insert(QStringLiteral("elapsed_ms"), double(elapsedMs));
+    return object;
+}
+
+// 解析整数参数并检查范围；无效时输出错误并返回 false，调用方以退出码 2 结束
+static bool parseIntOption(const char *name, const QString &text, int min, int max, int *value)
+{
+    bool ok = false;
+    const int parsed = text.trimmed().toInt(&ok);
+    if (!ok || parsed < min || parsed > max) {
+        qCritical() << "Invalid" << name << text << "- expected" << min << "to" << max;
+        return false;
+    }
+    *value = parsed;
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("FinderCli"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Headless device discovery"));
+    parser.addHelpOption();
+    QCommandLineOption methodsOption(QStringList{"m", "methods"},
+        QStringLiteral("Comma separated discovery methods: broadcast, mdns, scan, ipv6."),
+        QStringLiteral("list"), QStringLiteral("broadcast,scan"));
+    QCommandLineOption targetOption(QStringList{"t", "target"},
+        QStringLiteral("Probe only these targets: comma separated IPv4 hosts, ranges"
+                       " (10.0.0.5-10.0.0.99) and CIDR blocks (10.1.4.0/24)."),
+        QStringLiteral("list"));
+    QCommandLineOption tcpPortOption(QStringLiteral("tcp-port"),
+        QStringLiteral("TCP listen port."), QStringLiteral("port"), QString::number(TCP_LISTEN_PORT));
+    QCommandLineOption udpPortOption(QStringLiteral("udp-port"),
+        QStringLiteral("UDP listen port."), QStringLiteral("port"), QString::number(UDP_LISTEN_PORT));
+    QCommandLineOption targetPortOption(QStringLiteral("target-port"),
+        QStringLiteral("Device UDP port probes are sent to."), QStringLiteral("port"),
+        QString::number(UDP_TARGET_PORT));
+    QCommandLineOption rateOption(QStringList{"r", "rate"},
+        QStringLiteral("Sweep budget in packets per second."), QStringLiteral("pps"),
+        QStringLiteral("1000"));
+    QCommandLineOption timeoutOption(QStringLiteral("timeout"),
+        QStringLiteral("Give up after this many milliseconds."), QStringLiteral("ms"),
+        QStringLiteral("10000"));
+    QCommandLineOption continuousOption(QStringList{"c", "continuous"},
+        QStringLiteral("Keep discovering until the timeout and report every device."));
+    QCommandLineOption metricsPortOption(QStringLiteral("metrics-port"),
+        QStringLiteral("Serve a JSON metrics snapshot on this localhost TCP port."),
+        QStringLiteral("port"));
+    QCommandLineOption monitorOption(QStringLiteral("monitor"),
+        QStringLiteral("Heartbeat found devices every <ms> and report down/up events."
+                       " Implies --continuous."),
+        QStringLiteral("ms"));
+    QCommandLineOption dhcpRangeOption(QStringLiteral("dhcp-range"),
+        QStringLiteral("Addresses probed first during a sweep, e.g. 192.168.1.100-200."
+                       " Accepts the same forms as --target and may be given more than once."),
+        QStringLiteral("list"));
+    QCommandLineOption captureOption(QStringLiteral("capture"),
+        QStringLiteral("Record sent probes and received traffic to <file>."), QStringLiteral("file"));
+    QCommandLineOption replayOption(QStringLiteral("replay"),
+        QStringLiteral("Replay a capture offline instead of discovering; reports every device"
+                       " found in it and exits."), QStringLiteral("file"));
+    QCommandLineOption servicesOption(QStringLiteral("services"),
+        QStringLiteral("TCP ports to probe on every found device, e.g. 22,23,80,8000-8100."),
+        QStringLiteral("ports"));
+    QCommandLineOption serviceConcurrencyOption(QStringLiteral("service-concurrency"),
+        QStringLiteral("Service probe connections in flight, overall and per device."),
+        QStringLiteral("total,per-host"), QStringLiteral("256,4"));
+    QCommandLineOption exportOption(QStringLiteral("export"),
+        QStringLiteral("Write the device inventory to <file> when done (.json for JSON, otherwise CSV)."),
+        QStringLiteral("file"));
+    parser.addOptions({methodsOption, targetOption, tcpPortOption, udpPortOption,
+                       targetPortOption, rateOption, timeoutOption, continuousOption,
+                       metricsPortOption, dhcpRangeOption, monitorOption,
+                       captureOption, replayOption, servicesOption, serviceConcurrencyOption,
+                       exportOption});
+    parser.process(app);
+
+    const QStringList methods = parser.value(methodsOption).split(',', Qt::SkipEmptyParts);
+    QVector<bool> method = {methods.contains(QStringLiteral("broadcast")),
+                            methods.contains(QStringLiteral("mdns")),
+                            methods.contains(QStringLiteral("scan")),
+                            methods.contains(QStringLiteral("ipv6"))};
+    const QString target = parser.value(targetOption);
+    const bool replay = parser.isSet(replayOption);
+    if (!replay && !method.contains(true) && target.isEmpty()) {
+        qCritical() << "No discovery method selected";
+        return 2;
+    }
+    IntervalSet targets;
+    QString specError;
+    if (!TargetSpec::parse(target, &targets, &specError)
+        || (!target.trimmed().isEmpty() && targets.isEmpty())) {
+        qCritical() << "Invalid target list:" << target << specError;
+        return 2;
+    }
+
+    IntervalSet hintRanges;
+    for (const QString &spec : parser.values(dhcpRangeOption)) {
+        if (!TargetSpec::parse(spec, &hintRanges, &specError)) {
+            qCritical() << "Invalid DHCP range:" << spec << specError;
+            return 2;
+        }
+    }
+
+    QVector<quint16> servicePorts;
+    if (!ServiceProber::parsePorts(parser.value(servicesOption), &servicePorts, &specError)) {
+        qCritical() << "Invalid service ports:" << specError;
+        return 2;
+    }
+    const QStringList concurrency = parser.value(serviceConcurrencyOption).split(',');
+    int maxInFlight = 0;
+    int maxPerHost = 4;
+    if (concurrency.size() > 2
+        || !parseIntOption("--service-concurrency", concurrency.value(0), 1, 65536, &maxInFlight)
+        || (concurrency.size() == 2
+            && !parseIntOption("--service-concurrency", concurrency.at(1), 1, 65536, &maxPerHost))) {
+        return 2;
+    }
+
+    int tcpPort = 0;
+    int udpPort = 0;
+    int targetPort = 0;
+    int sendRate = 0;
+    int timeoutMs = 0;
+    if (!parseIntOption("--tcp-port", parser.value(tcpPortOption), 1, 65535, &tcpPort)
+        || !parseIntOption("--udp-port", parser.value(udpPortOption), 1, 65535, &udpPort)
+        || !parseIntOption("--target-port", parser.value(targetPortOption), 1, 65535, &targetPort)
+        || !parseIntOption("--rate", parser.value(rateOption), 1, 10000000, &sendRate)
+        || !parseIntOption("--timeout", parser.value(timeoutOption), 1, INT_MAX, &timeoutMs)) {
+        return 2;
+    }
+
+    MetricsExporter exporter;
+    if (parser.isSet(metricsPortOption)) {
+        int metricsPort = 0;
+        if (!parseIntOption("--metrics-port", parser.value(metricsPortOption), 1, 65535, &metricsPort)
+            || !exporter.listen(quint16(metricsPort))) {
+            return 2;
+        }
+    }
+
+    int monitorMs = 0;
+    if (parser.isSet(monitorOption)
+        && !parseIntOption("--monitor", parser.value(monitorOption), 1, INT_MAX, &monitorMs)) {
+        return 2;
+    }
+    // 回放时报告抓包中的所有设备
+    const bool continuous = parser.isSet(continuousOption) || monitorMs > 0 || replay;
+    DiscoveryProfile profile;
+    profile.name = QStringLiteral("cli");
+    profile.targets = target;
+    profile.methods = method;
+    profile.tcpPort = quint16(tcpPort);
+    profile.udpPort = quint16(udpPort);
+    profile.targetUdpPort = quint16(targetPort);
+    profile.sendRate = sendRate;
+    profile.continuous = continuous;
+
+    // 会话结束时 finder 被释放，之后不再访问
+    DiscoverySession session(profile);
+    session.setDeadline(timeoutMs);
+    DeviceFinder &finder = *session.finder();
+    finder.setSweepHints(hintRanges.ranges());
+    finder.setLivenessInterval(monitorMs);
+    finder.services()->setMaxInFlight(maxInFlight);
+    finder.services()->setMaxPerHost(maxPerHost);
+    finder.setServicePorts(servicePorts);
+    if (parser.isSet(captureOption) && !finder.setCaptureFile(parser.value(captureOption))) {
+        return 2;
+    }
+
+    QElapsedTimer clock;
+    clock.start();
+    int found = 0;
+
+    auto foundJson = [&](const DeviceRecord &record) {
+        ++found;
+        emitJson(recordJson("found", record, clock.elapsed()));
+    };
+    QObject::connect(finder.services(), &ServiceProber::hostProbed, &app,
+                     [&](const DeviceAddress &address, const QVector<quint16> &openPorts) {
+        QJsonArray ports;
+        for (quint16 port : openPorts) {
+            ports.append(int(port));
+        }
+        QJsonObject object;
+        object.insert(QStringLiteral("event"), QStringLiteral("services"));
+        object.insert(QStringLiteral("ip"), address.toHostAddress().toString());
+        object.insert(QStringLiteral("open_ports"), ports);
+        object.insert(QStringLiteral("elapsed_ms"), double(clock.elapsed()));
+        emitJson(object);
+    });
+    QObject::connect(finder.registry(), &DeviceRegistry::deviceExpired, &app,
+                     [&](const DeviceRecord &record) {
+        emitJson(recordJson("expired", record, clock.elapsed()));
+    });
+
+    auto livenessJson = [&](const char *event, const DeviceAddress &address) {
+        const LivenessMonitor::Stats stats = finder.liveness()->stats(address);
+        QJsonObject object;
+        object.insert(QStringLiteral("event"), QLatin1String(event));
+        object.insert(QStringLiteral("ip"), address.toHostAddress().toString());
+        object.insert(QStringLiteral("srtt_us"), double(stats.srttUs));
+        object.insert(QStringLiteral("rttvar_us"), double(stats.rttvarUs));
+        object.insert(QStringLiteral("elapsed_ms"), double(clock.elapsed()));
+        emitJson(object);
+    };
+    QObject::connect(finder.liveness(), &LivenessMonitor::deviceDown, &app,
+                     [&](const DeviceAddress &address) { livenessJson("down", address); });
+    QObject::connect(finder.liveness(), &LivenessMonitor::deviceUp, &app,
+                     [&](const DeviceAddress &address) { livenessJson("up", address); });
+
+    auto done = [&](const DeviceRegistry *registry, const char *reason, qint64 records) {
+        QJsonObject object;
+        object.insert(QStringLiteral("event"), QStringLiteral("done"));
+        object.insert(QStringLiteral("reason"), QLatin1String(reason));
+        object.insert(QStringLiteral("devices"), found);
+        if (records >= 0) {
+            object.insert(QStringLiteral("records"), double(records));
+        }
+        object.insert(QStringLiteral("elapsed_ms"), double(clock.elapsed()));
+        object.insert(QStringLiteral("metrics"), DiscoveryMetrics::instance().snapshot().toJson());
+        if (parser.isSet(exportOption)) {
+            // 直接从设备表流式写出，不复制
+            QString error;
+            const int exported = registry
+                ? DeviceExport::writeFile(*registry, parser.value(exportOption), &error)
+                : DeviceExport::writeFile(parser.value(exportOption), [](auto) {}, &error);
+            if (exported < 0) {
+                qWarning() << "Export failed:" << error;
+            }
+            object.insert(QStringLiteral("exported"), exported);
+        }
+        emitJson(object);
+    };
+
+    if (replay) {
+        // 离线回放：不开始会话，不绑定端口、不发送探测
+        QObject::connect(finder.registry(), &DeviceRegistry::deviceAdded, &app, foundJson);
+        QTimer::singleShot(0, &app, [&]() {
+            const qint64 records = finder.replayCapture(parser.value(replayOption));
+            if (records < 0) {
+                app.exit(2);
+                return;
+            }
+            done(finder.registry(), "replay", records);
+            app.exit(found > 0 ? 0 : 1);
+        });
+        return app.exec();
+    }
+
+    QObject::connect(&session, &DiscoverySession::deviceFound, &app, foundJson);
+    // 在 finder 释放前导出，设备表只在该信号处理期间有效
+    QObject::connect(&session, &DiscoverySession::finishing, &app,
+                     [&](const DeviceRegistry *registry, DiscoverySession::EndReason reason) {
+        done(registry, DiscoverySession::endReasonName(reason), -1);
+        if (reason == DiscoverySession::EndReason::ListenFailed) {
+            app.exit(2);
+            return;
+        }
+        app.exit(found > 0 ? 0 : 1);
+    });
+
+    QTimer::singleShot(0, &session, &DiscoverySession::start);
+
+    return app.exec();
+}
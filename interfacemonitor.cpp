@@ -0,0 +1,337 @@
+#include "interfacemonitor.h"
+#include "discoverymetrics.h"
+
+#include <QSocketNotifier>
+
+#ifdef Q_OS_LINUX
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+// 合并变化通知的窗口
+constexpr int INTERFACE_SETTLE_MS = 200;
+// 无 netlink 时重新枚举的间隔
+constexpr int INTERFACE_POLL_MS = 10000;
+
+namespace {
+bool sameEntries(const QList<QNetworkAddressEntry> &a, const QList<QNetworkAddressEntry> &b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (int i = 0; i < a.size(); ++i) {
+        if (a.at(i).ip() != b.at(i).ip() || a.at(i).prefixLength() != b.at(i).prefixLength()) {
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+InterfaceMonitor::InterfaceMonitor(QObject *parent)
+    : QObject(parent)
+{
+    m_changeTimer = new QTimer(this);
+    m_changeTimer->setSingleShot(true);
+    m_changeTimer->setInterval(INTERFACE_SETTLE_MS);
+    connect(m_changeTimer, &QTimer::timeout, this, &InterfaceMonitor::changed);
+
+    // 先订阅再枚举，枚举期间发生的变化不会丢失
+    openNetlink();
+    refresh();
+
+    if (m_netlinkFd < 0) {
+        m_pollTimer = new QTimer(this);
+        m_pollTimer->setInterval(INTERFACE_POLL_MS);
+        connect(m_pollTimer, &QTimer::timeout, this, [this]() {
+            const QList<InterfaceInfo> before = interfaces();
+            refresh();
+            const QList<InterfaceInfo> after = interfaces();
+            bool same = before.size() == after.size();
+            for (int i = 0; same && i < before.size(); ++i) {
+                same = before.at(i).flags == after.at(i).flags
+                    && sameEntries(before.at(i).entries, after.at(i).entries);
+            }
+            if (!same) {
+                scheduleChanged();
+            }
+        });
+        m_pollTimer->start();
+    }
+}
+
+InterfaceMonitor::~InterfaceMonitor()
+{
+#ifdef Q_OS_LINUX
+    if (m_netlinkFd >= 0) {
+        ::close(m_netlinkFd);
+    }
+#endif
+}
+
+void InterfaceMonitor::refresh()
+{
+    m_interfaces.clear();
+    foreach (const QNetworkInterface &interface, QNetworkInterface::allInterfaces()) {
+        InterfaceInfo info;
+        info.index = interface.index();
+        info.name = interface.name();
+        info.type = interface.type();
+        info.flags = interface.flags();
+        info.entries = interface.addressEntries();
+        m_interfaces.insert(info.index, info);
+    }
+}
+
+QList<QNetworkAddressEntry> InterfaceMonitor::subnets() const
+{
+    QList<QNetworkAddressEntry> subnets;
+    for (const InterfaceInfo &info : m_interfaces) {
+        if (!info.isValid() || !info.flags.testFlag(QNetworkInterface::IsRunning)) {
+            continue;
+        }
+        for (const QNetworkAddressEntry &entry : info.entries) {
+            if (entry.ip().protocol() == QAbstractSocket::IPv4Protocol &&
+                !entry.ip().isLoopback() && entry.prefixLength() < 31) {
+                subnets.append(entry);
+            }
+        }
+    }
+    return subnets;
+}
+
+QList<int> InterfaceMonitor::ipv6Interfaces() const
+{
+    QList<int> indexes;
+    for (const InterfaceInfo &info : m_interfaces) {
+        if (!info.isValid() || !info.flags.testFlag(QNetworkInterface::IsRunning) ||
+            !info.flags.testFlag(QNetworkInterface::CanMulticast)) {
+            continue;
+        }
+        for (const QNetworkAddressEntry &entry : info.entries) {
+            if (entry.ip().protocol() == QAbstractSocket::IPv6Protocol) {
+                indexes.append(info.index);
+                break;
+            }
+        }
+    }
+    return indexes;
+}
+
+QPair<QHostAddress, QHostAddress> InterfaceMonitor::primaryAddress() const
+{
+    for (const InterfaceInfo &info : m_interfaces) {
+        if (!info.flags.testFlag(QNetworkInterface::IsUp) ||
+            !info.flags.testFlag(QNetworkInterface::IsRunning)) {
+            continue;
+        }
+        if (info.type != QNetworkInterface::Ethernet && info.type != QNetworkInterface::Ieee80211) {
+            continue;
+        }
+        if (info.name.contains("VMware", Qt::CaseInsensitive) ||
+            info.name.contains("Bluetooth", Qt::CaseInsensitive)) {
+            continue;
+        }
+        for (const QNetworkAddressEntry &entry : info.entries) {
+            if (!entry.ip().isLoopback() && entry.ip().protocol() == QAbstractSocket::IPv4Protocol) {
+                return qMakePair(entry.ip(), entry.netmask());
+            }
+        }
+    }
+    return qMakePair(QHostAddress(QHostAddress::LocalHost), QHostAddress(QHostAddress::LocalHost));
+}
+
+void InterfaceMonitor::scheduleChanged()
+{
+    if (!m_changeTimer->isActive()) {
+        m_changeTimer->start();
+    }
+}
+
+void InterfaceMonitor::openNetlink()
+{
+#ifdef Q_OS_LINUX
+    const int fd = ::socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0) {
+        qWarning() << "Interface monitor: netlink unavailable," << std::strerror(errno);
+        return;
+    }
+    sockaddr_nl local;
+    std::memset(&local, 0, sizeof(local));
+    local.nl_family = AF_NETLINK;
+    local.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+    if (::bind(fd, reinterpret_cast<sockaddr *>(&local), sizeof(local)) < 0) {
+        qWarning() << "Interface monitor: netlink bind failed," << std::strerror(errno);
+        ::close(fd);
+        return;
+    }
+    m_netlinkFd = fd;
+    m_notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &InterfaceMonitor::readNetlink);
+#endif
+}
+
+void InterfaceMonitor::readNetlink()
+{
+#ifdef Q_OS_LINUX
+    alignas(nlmsghdr) char buffer[16384];
+    for (;;) {
+        const ssize_t received = ::recv(m_netlinkFd, buffer, sizeof(buffer), 0);
+        if (received < 0) {
+            if (errno == ENOBUFS) {
+                // 接收缓冲区溢出，丢失了通知：整体重新枚举
+                FINDER_TRACE() << "Interface monitor overrun, re-enumerating";
+                refresh();
+                scheduleChanged();
+                continue;
+            }
+            break;
+        }
+        if (received == 0) {
+            break;
+        }
+        int remaining = int(received);
+        for (nlmsghdr *header = reinterpret_cast<nlmsghdr *>(buffer); NLMSG_OK(header, remaining);
+             header = NLMSG_NEXT(header, remaining)) {
+            handleMessage(header);
+        }
+    }
+#endif
+}
+
+void InterfaceMonitor::handleMessage(const void *message)
+{
+#ifdef Q_OS_LINUX
+    const nlmsghdr *header = static_cast<const nlmsghdr *>(message);
+    switch (header->nlmsg_type) {
+    case RTM_NEWLINK:
+    case RTM_DELLINK: {
+        const ifinfomsg *link = static_cast<const ifinfomsg *>(NLMSG_DATA(header));
+        auto it = m_interfaces.find(link->ifi_index);
+        if (header->nlmsg_type == RTM_DELLINK) {
+            if (it != m_interfaces.end()) {
+                m_interfaces.erase(it);
+                scheduleChanged();
+            }
+            return;
+        }
+        if (it == m_interfaces.end()) {
+            // 新网卡：类型等信息只能完整枚举得到，新增网卡很少见
+            refresh();
+            scheduleChanged();
+            return;
+        }
+        QNetworkInterface::InterfaceFlags flags;
+        const unsigned int raw = link->ifi_flags;
+        flags.setFlag(QNetworkInterface::IsUp, raw & IFF_UP);
+        flags.setFlag(QNetworkInterface::IsRunning, raw & IFF_RUNNING);
+        flags.setFlag(QNetworkInterface::CanBroadcast, raw & IFF_BROADCAST);
+        flags.setFlag(QNetworkInterface::IsLoopBack, raw & IFF_LOOPBACK);
+        flags.setFlag(QNetworkInterface::IsPointToPoint, raw & IFF_POINTOPOINT);
+        flags.setFlag(QNetworkInterface::CanMulticast, raw & IFF_MULTICAST);
+        if (flags != it->flags) {
+            it->flags = flags;
+            scheduleChanged();
+        }
+        return;
+    }
+    case RTM_NEWADDR:
+    case RTM_DELADDR: {
+        const ifaddrmsg *address = static_cast<const ifaddrmsg *>(NLMSG_DATA(header));
+        if (address->ifa_family != AF_INET && address->ifa_family != AF_INET6) {
+            return;
+        }
+        auto it = m_interfaces.find(int(address->ifa_index));
+        if (it == m_interfaces.end()) {
+            if (header->nlmsg_type == RTM_NEWADDR) {
+                refresh();
+                scheduleChanged();
+            }
+            return;
+        }
+
+        QHostAddress ip;
+        QHostAddress broadcast;
+        int length = int(header->nlmsg_len) - int(NLMSG_LENGTH(sizeof(ifaddrmsg)));
+        const rtattr *attribute = reinterpret_cast<const rtattr *>(
+            reinterpret_cast<const char *>(address) + NLMSG_ALIGN(sizeof(ifaddrmsg)));
+        for (; RTA_OK(attribute, length); attribute = RTA_NEXT(attribute, length)) {
+            const quint8 *data = static_cast<const quint8 *>(RTA_DATA(attribute));
+            const int size = int(RTA_PAYLOAD(attribute));
+            QHostAddress value;
+            if (address->ifa_family == AF_INET && size == 4) {
+                quint32 be;
+                std::memcpy(&be, data, 4);
+                value = QHostAddress(ntohl(be));
+            } else if (address->ifa_family == AF_INET6 && size == 16) {
+                value = QHostAddress(data);
+            } else {
+                continue;
+            }
+            // 点对点链路上 IFA_ADDRESS 是对端地址，本机地址以 IFA_LOCAL 为准
+            if (attribute->rta_type == IFA_LOCAL) {
+                ip = value;
+            } else if (attribute->rta_type == IFA_ADDRESS && ip.isNull()) {
+                ip = value;
+            } else if (attribute->rta_type == IFA_BROADCAST) {
+                broadcast = value;
+            }
+        }
+        if (ip.isNull()) {
+            return;
+        }
+        if (ip.protocol() == QAbstractSocket::IPv6Protocol && ip.isLinkLocal()) {
+            ip.setScopeId(it->name);
+        }
+
+        QList<QNetworkAddressEntry> &entries = it->entries;
+        int existing = -1;
+        for (int i = 0; i < entries.size(); ++i) {
+            if (entries.at(i).ip().isEqual(ip, QHostAddress::StrictConversion)) {
+                existing = i;
+                break;
+            }
+        }
+        if (header->nlmsg_type == RTM_DELADDR) {
+            if (existing >= 0) {
+                entries.removeAt(existing);
+                scheduleChanged();
+            }
+            return;
+        }
+
+        QNetworkAddressEntry entry;
+        entry.setIp(ip);
+        entry.setPrefixLength(address->ifa_prefixlen);
+        if (broadcast.isNull() && ip.protocol() == QAbstractSocket::IPv4Protocol &&
+            address->ifa_prefixlen < 31) {
+            broadcast = QHostAddress(ip.toIPv4Address() | ~entry.netmask().toIPv4Address());
+        }
+        if (!broadcast.isNull()) {
+            entry.setBroadcast(broadcast);
+        }
+        if (existing >= 0) {
+            const QNetworkAddressEntry &old = entries.at(existing);
+            if (old.prefixLength() == entry.prefixLength() && old.broadcast() == entry.broadcast()) {
+                return;
+            }
+            entries[existing] = entry;
+        } else {
+            entries.append(entry);
+        }
+        scheduleChanged();
+        return;
+    }
+    default:
+        return;
+    }
+#else
+    Q_UNUSED(message);
+#endif
+}
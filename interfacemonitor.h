@@ -0,0 +1,67 @@
+#ifndef INTERFACEMONITOR_H
+#define INTERFACEMONITOR_H
+
+#include <QObject>
+#include <QNetworkInterface>
+#include <QHostAddress>
+#include <QTimer>
+#include <QMap>
+#include <QList>
+#include <QPair>
+
+class QSocketNotifier;
+
+// 网卡快照中的一项；由 QNetworkInterface 初始化，之后按内核通知增量更新
+struct InterfaceInfo {
+    int index = 0;
+    QString name;
+    QNetworkInterface::InterfaceType type = QNetworkInterface::Unknown;
+    QNetworkInterface::InterfaceFlags flags;
+    QList<QNetworkAddressEntry> entries;
+
+    // 与 NetworkUtils::getValidInterfaces 相同：已启用且不是回环
+    bool isValid() const {
+        return flags.testFlag(QNetworkInterface::IsUp) && !flags.testFlag(QNetworkInterface::IsLoopBack);
+    }
+};
+
+// 缓存网卡与地址快照，避免每次发送前都完整枚举一遍网卡。
+// Linux 上订阅 netlink 的 RTM_NEWADDR / RTM_DELADDR / RTM_NEWLINK / RTM_DELLINK 增量更新，
+// 其它平台定期重新枚举。短时间内的多次变化（如 DHCP 续租先删后加）合并为一次 changed()
+class InterfaceMonitor : public QObject {
+    Q_OBJECT
+
+public:
+    explicit InterfaceMonitor(QObject *parent = nullptr);
+    ~InterfaceMonitor() override;
+
+    QList<InterfaceInfo> interfaces() const { return m_interfaces.values(); }
+
+    // 以下查询与 NetworkUtils 中的同名枚举结果一致，但只读缓存
+    QList<QNetworkAddressEntry> subnets() const;
+    // 运行中、支持组播且带 IPv6 地址的网卡索引
+    QList<int> ipv6Interfaces() const;
+    // 第一个有线或无线网卡上的 IPv4 地址与掩码，没有时为两个 LocalHost
+    QPair<QHostAddress, QHostAddress> primaryAddress() const;
+
+    // 丢弃快照并完整重新枚举
+    void refresh();
+
+signals:
+    void changed();
+
+private:
+    void openNetlink();
+    void readNetlink();
+    // header 指向一条 nlmsghdr
+    void handleMessage(const void *header);
+    void scheduleChanged();
+
+    QMap<int, InterfaceInfo> m_interfaces;
+    int m_netlinkFd = -1;
+    QSocketNotifier *m_notifier = nullptr;
+    QTimer *m_changeTimer;
+    QTimer *m_pollTimer = nullptr;
+};
+
+#endif // INTERFACEMONITOR_H
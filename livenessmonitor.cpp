@@ -0,0 +1,239 @@
+#include "livenessmonitor.h"
+#include "discoverylistener.h"
+#include "discoverycapture.h"
+#include "discoverymetrics.h"
+#include "subnetsweeper.h"
+
+#include <QVector>
+
+#include <cstdlib>
+
+// 时间轮节拍；探测间隔与超时都按节拍取整
+constexpr int LIVENESS_TICK_MS = 50;
+constexpr int LIVENESS_WHEEL_SLOTS = 256;
+// 尚无 RTT 样本时的 RTO（RFC 6298 初值），以及 RTO 的上下限
+constexpr qint64 LIVENESS_INITIAL_RTO_US = 1000000;
+constexpr qint64 LIVENESS_MIN_RTO_US = 20000;
+constexpr qint64 LIVENESS_MAX_RTO_US = 60000000;
+
+LivenessMonitor::LivenessMonitor(DiscoveryListener *listener, quint16 targetPort, QObject *parent)
+    : QObject(parent)
+    , m_listener(listener)
+    , m_targetPort(targetPort)
+    , m_probeWheel(LIVENESS_WHEEL_SLOTS)
+    , m_deadlineWheel(LIVENESS_WHEEL_SLOTS)
+{
+    qRegisterMetaType<DeviceAddress>("DeviceAddress");
+    m_tickTimer = new QTimer(this);
+    m_tickTimer->setInterval(LIVENESS_TICK_MS);
+    connect(m_tickTimer, &QTimer::timeout, this, &LivenessMonitor::onTick);
+    connect(m_listener, &DiscoveryListener::heartbeat, this, &LivenessMonitor::onHeartbeat);
+}
+
+void LivenessMonitor::setInterval(int ms)
+{
+    m_intervalMs = qMax(LIVENESS_TICK_MS, ms);
+}
+
+void LivenessMonitor::watch(const DeviceAddress &address)
+{
+    if (address.isNull() || m_peers.contains(address)) {
+        return;
+    }
+    Peer &peer = m_peers[address];
+    peer.watchedUs = SubnetSweeper::clockUs();
+    // 首个探测按地址错开到一个间隔内，批量加入时不会同时发出
+    const int ticks = intervalTicks();
+    m_probeWheel.schedule(address, 1 + int(qHash(address) % uint(ticks)));
+    if (!m_tickTimer->isActive()) {
+        m_tickTimer->start();
+    }
+}
+
+void LivenessMonitor::unwatch(const DeviceAddress &address)
+{
+    m_peers.remove(address);
+    m_probeWheel.cancel(address);
+    m_deadlineWheel.cancel(address);
+    if (m_peers.isEmpty()) {
+        m_tickTimer->stop();
+    }
+}
+
+void LivenessMonitor::clear()
+{
+    for (auto it = m_peers.cbegin(); it != m_peers.cend(); ++it) {
+        m_probeWheel.cancel(it.key());
+        m_deadlineWheel.cancel(it.key());
+    }
+    m_peers.clear();
+    m_tickTimer->stop();
+}
+
+LivenessMonitor::Stats LivenessMonitor::stats(const DeviceAddress &address) const
+{
+    auto it = m_peers.constFind(address);
+    return it == m_peers.constEnd() ? Stats() : it->stats;
+}
+
+int LivenessMonitor::intervalTicks() const
+{
+    return qMax(1, (m_intervalMs + LIVENESS_TICK_MS - 1) / LIVENESS_TICK_MS);
+}
+
+qint64 LivenessMonitor::rtoUs(const Peer &peer) const
+{
+    if (peer.stats.srttUs < 0) {
+        return LIVENESS_INITIAL_RTO_US;
+    }
+    return qBound(LIVENESS_MIN_RTO_US, peer.stats.srttUs + 4 * peer.stats.rttvarUs, LIVENESS_MAX_RTO_US);
+}
+
+void LivenessMonitor::armDeadline(const DeviceAddress &address, qint64 deadlineUs, qint64 now)
+{
+    const qint64 tickUs = qint64(LIVENESS_TICK_MS) * 1000;
+    m_deadlineWheel.schedule(address, int((deadlineUs - now + tickUs - 1) / tickUs));
+}
+
+qint64 LivenessMonitor::collectMisses(Peer &peer, qint64 now) const
+{
+    const qint64 rto = rtoUs(peer);
+    qint64 next = -1;
+    for (int i = 0; i < LIVENESS_PIPELINE; ++i) {
+        const qint64 sent = peer.outstandingUs[i];
+        if (sent <= 0) {
+            continue;
+        }
+        if (now - sent >= rto) {
+            peer.outstandingUs[i] = 0;
+            ++peer.misses;
+        } else if (next < 0 || sent + rto < next) {
+            next = sent + rto;
+        }
+    }
+    return next;
+}
+
+void LivenessMonitor::checkDown(const DeviceAddress &address, Peer &peer, qint64 now)
+{
+    if (!peer.stats.up || peer.misses < m_missLimit) {
+        return;
+    }
+    peer.stats.up = false;
+    countMetric(MetricCounter::DevicesDown);
+    const qint64 since = peer.stats.lastReplyUs >= 0 ? peer.stats.lastReplyUs : peer.watchedUs;
+    emit deviceDown(address, now - since);
+}
+
+void LivenessMonitor::onTick()
+{
+    // 先收集到期项再发送，避免在时间轮回调中改动设备表
+    QVector<DeviceAddress> due;
+    m_probeWheel.advance([&due](const DeviceAddress &address) { due.append(address); });
+    const int ticks = intervalTicks();
+    for (const DeviceAddress &address : due) {
+        auto it = m_peers.find(address);
+        if (it == m_peers.end()) {
+            continue;
+        }
+        sendProbe(address, *it);
+        m_probeWheel.schedule(address, ticks);
+    }
+
+    due.resize(0);
+    m_deadlineWheel.advance([&due](const DeviceAddress &address) { due.append(address); });
+    const qint64 now = SubnetSweeper::clockUs();
+    for (const DeviceAddress &address : due) {
+        auto it = m_peers.find(address);
+        if (it == m_peers.end()) {
+            continue;
+        }
+        // 时间轮中每台设备只挂最早的截止时刻，处理后再挂下一个未到期探测
+        const qint64 next = collectMisses(*it, now);
+        if (next >= 0) {
+            armDeadline(address, next, now);
+        }
+        checkDown(address, *it, now);
+    }
+}
+
+void LivenessMonitor::sendProbe(const DeviceAddress &address, Peer &peer)
+{
+    Frame frame;
+    frame.type = FrameType::Heartbeat;
+    frame.sequence = LIVENESS_SEQUENCE_FLAG | (++m_sequence & ~LIVENESS_SEQUENCE_FLAG);
+    const qint64 now = SubnetSweeper::clockUs();
+    frame.timestampUs = quint64(now);
+
+    const int slot = int(frame.sequence % LIVENESS_PIPELINE);
+    // 环已转满一圈仍未应答的探测直接记为丢失
+    if (peer.outstandingUs[slot] > 0) {
+        ++peer.misses;
+    }
+    peer.outstandingSeq[slot] = frame.sequence;
+    peer.outstandingUs[slot] = now;
+    ++peer.stats.sent;
+    if (!m_deadlineWheel.contains(address)) {
+        armDeadline(address, now + rtoUs(peer), now);
+    }
+    checkDown(address, peer, now);
+
+    const QByteArray probe = DiscoveryProtocol::encode(frame);
+    if (m_listener->udpSocket()->writeDatagram(probe, address.toHostAddress(), m_targetPort) < 0) {
+        countMetric(MetricCounter::SendErrors);
+        return;
+    }
+    countMetric(MetricCounter::LivenessProbesSent);
+    if (CaptureWriter *capture = CaptureWriter::active()) {
+        capture->append(CaptureKind::ProbeSent, address, m_targetPort, probe.constData(), probe.size());
+    }
+}
+
+void LivenessMonitor::onHeartbeat(const DeviceAddress &address, qint64 rttUs, quint64 deviceId,
+                                  quint32 sequence)
+{
+    Q_UNUSED(rttUs);
+    Q_UNUSED(deviceId);
+    auto it = m_peers.find(address);
+    if (it == m_peers.end()) {
+        return;
+    }
+    Peer &peer = *it;
+    const qint64 now = SubnetSweeper::clockUs();
+    if ((sequence & LIVENESS_SEQUENCE_FLAG) || sequence == 0) {
+        countMetric(MetricCounter::LivenessRepliesReceived);
+    }
+
+    // 只有仍在环中的序号产生 RTT 样本；重复或过晚的应答、旧协议心跳（序号 0）
+    // 与发现应答只说明设备在线
+    qint64 answeredUs = now;
+    const int slot = int(sequence % LIVENESS_PIPELINE);
+    if ((sequence & LIVENESS_SEQUENCE_FLAG) && peer.outstandingSeq[slot] == sequence
+        && peer.outstandingUs[slot] > 0) {
+        answeredUs = peer.outstandingUs[slot];
+        const qint64 sample = now - answeredUs;
+        Stats &stats = peer.stats;
+        if (stats.srttUs < 0) {
+            stats.srttUs = sample;
+            stats.rttvarUs = sample / 2;
+        } else {
+            stats.rttvarUs = (3 * stats.rttvarUs + std::llabs(stats.srttUs - sample)) / 4;
+            stats.srttUs = (7 * stats.srttUs + sample) / 8;
+        }
+        DiscoveryMetrics::instance().recordRtt(sample);
+    }
+
+    // 早于被应答探测发出的探测不再等待；不带序号的应答清空全部未应答探测
+    for (int i = 0; i < LIVENESS_PIPELINE; ++i) {
+        if (peer.outstandingUs[i] > 0 && peer.outstandingUs[i] <= answeredUs) {
+            peer.outstandingUs[i] = 0;
+        }
+    }
+    peer.misses = 0;
+    ++peer.stats.received;
+    peer.stats.lastReplyUs = now;
+    if (!peer.stats.up) {
+        peer.stats.up = true;
+        emit deviceUp(address, peer.stats.srttUs);
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef LIVENESSMONITOR_H
+#define LIVENESSMONITOR_H
+
+#include <QObject>
+#include <QTimer>
+#include <QHash>
+
+#include "deviceaddress.h"
+#include "timerwheel.h"
+
+class DiscoveryListener;
+
+// 已发现设备的在线检测：经共享监听套接字按固定间隔向每台设备发送带序号的心跳帧，
+// 不等待上一个应答（流水线）。按 RFC 6298 维护平滑 RTT 与抖动，每个探测的截止时刻为
+// 发出时刻加 RTO (SRTT + 4 * RTTVAR)，连续 missLimit 个探测超过截止时刻仍无应答即判定离线。
+// 来自该地址的任何心跳（含旧协议的字符串心跳）都视为在线，但只有回显序号的应答产生 RTT 样本。
+// 发送与超时都挂在同一个时间轮上，由一个定时器驱动，设备数量不影响定时器个数
+class LivenessMonitor : public QObject {
+    Q_OBJECT
+
+public:
+    struct Stats {
+        bool up = true;
+        qint64 srttUs = -1;     // 尚无样本时为 -1
+        qint64 rttvarUs = -1;
+        qint64 lastReplyUs = -1;    // SubnetSweeper::clockUs
+        quint32 sent = 0;
+        quint32 received = 0;
+    };
+
+    LivenessMonitor(DiscoveryListener *listener, quint16 targetPort, QObject *parent = nullptr);
+
+    // 每台设备的探测间隔
+    void setInterval(int ms);
+    int interval() const { return m_intervalMs; }
+    // 连续超时（超过各自 RTO）的探测数达到该值后判定离线
+    void setMissLimit(int count) { m_missLimit = qMax(1, count); }
+    void setTargetPort(quint16 port) { m_targetPort = port; }
+
+    void watch(const DeviceAddress &address);
+    void unwatch(const DeviceAddress &address);
+    void clear();
+
+    bool isWatching(const DeviceAddress &address) const { return m_peers.contains(address); }
+    int size() const { return m_peers.size(); }
+    Stats stats(const DeviceAddress &address) const;
+
+signals:
+    void deviceDown(const DeviceAddress &address, qint64 silentUs);
+    void deviceUp(const DeviceAddress &address, qint64 srttUs);
+
+private slots:
+    void onTick();
+
+private:
+    // 未应答探测的环形记录，按 sequence % LIVENESS_PIPELINE 索引
+    static constexpr int LIVENESS_PIPELINE = 8;
+
+    struct Peer {
+        Stats stats;
+        quint32 outstandingSeq[LIVENESS_PIPELINE] = {};
+        qint64 outstandingUs[LIVENESS_PIPELINE] = {};
+        qint64 watchedUs = 0;
+        int misses = 0;     // 上次应答以来超时的探测数
+    };
+
+    void onHeartbeat(const DeviceAddress &address, qint64 rttUs, quint64 deviceId, quint32 sequence);
+    void sendProbe(const DeviceAddress &address, Peer &peer);
+    void armDeadline(const DeviceAddress &address, qint64 deadlineUs, qint64 now);
+    // 把超过 RTO 仍无应答的探测记为丢失，返回最早一个未到期探测的截止时刻，没有时返回 -1
+    qint64 collectMisses(Peer &peer, qint64 now) const;
+    void checkDown(const DeviceAddress &address, Peer &peer, qint64 now);
+    qint64 rtoUs(const Peer &peer) const;
+    int intervalTicks() const;
+
+    DiscoveryListener *m_listener;
+    quint16 m_targetPort;
+    QHash<DeviceAddress, Peer> m_peers;
+    TimerWheel<DeviceAddress> m_probeWheel;
+    TimerWheel<DeviceAddress> m_deadlineWheel;
+    QTimer *m_tickTimer;
+    quint32 m_sequence = 0;
+    int m_intervalMs = 1000;
+    int m_missLimit = 3;
+};
+
+#endif // LIVENESSMONITOR_H
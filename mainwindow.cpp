@@ -2,48 +2,171 @@
 #include "./ui_mainwindow.h"
 #include "networksettingsDialog.h"
 #include "devicefinder.h"
+#include "networkworker.h"
+#include "devicetablemodel.h"
+#include "deviceexport.h"
+#include "discoverymetrics.h"
 
+#include <QAction>
+#include <QMenu>
+#include <QFileDialog>
+#include <QHeaderView>
+#include <QLabel>
+#include <QMessageBox>
+#include <QSortFilterProxyModel>
+
+// 持续模式下对已发现设备做在线检测的心跳间隔
+constexpr int LIVENESS_INTERVAL_MS = 1000;
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
 {
     ui->setupUi(this);
-    QPair<QHostAddress, QHostAddress> ip_mask = NetworkUtils::getLocalIp();
-    qDebug() << "local IP:" << ip_mask.first;
-    qDebug() << "local IP netmask:" << ip_mask.second;
-
-
-    NetworkSettingsDialog dlg;
-    QVector<bool> method;
-    QString ipAddress;
-    quint16 tcpPort;
-    quint16 udpPort;
-    quint16 targetUdpPort;
-
-    if (dlg.exec() == QDialog::Accepted) {
-        method = dlg.broadcastMethods();
-        ipAddress = dlg.ipAddress();
-        tcpPort = dlg.tcpPort();
-        udpPort = dlg.udpPort();
-        targetUdpPort = dlg.targetUdpPort();
-        qDebug() << "IP Address:" << dlg.ipAddress();
-        qDebug() << "Methods" << method;
-        qDebug() << "TCP Port:" << dlg.tcpPort();
-        qDebug() << "UDP Port:" << dlg.udpPort();
-        qDebug() << "TARGET Port:" << dlg.targetUdpPort();
-        qDebug() << "Frequency:" << dlg.frequency();
+
+    // 结果表：模型按批更新，代理负责排序与过滤；固定行高使上万行时滚动不必逐行测量
+    m_deviceModel = new DeviceTableModel(this);
+    m_deviceProxy = new QSortFilterProxyModel(this);
+    m_deviceProxy->setSourceModel(m_deviceModel);
+    m_deviceProxy->setSortRole(DeviceTableModel::SortRole);
+    m_deviceProxy->setFilterKeyColumn(-1);
+    m_deviceProxy->setFilterCaseSensitivity(Qt::CaseInsensitive);
+    ui->deviceTable->setModel(m_deviceProxy);
+    ui->deviceTable->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    ui->deviceTable->verticalHeader()->setDefaultSectionSize(ui->deviceTable->fontMetrics().height() + 6);
+    ui->deviceTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
+    ui->deviceTable->sortByColumn(DeviceTableModel::AddressColumn, Qt::AscendingOrder);
+    connect(ui->deviceFilter, &QLineEdit::textChanged, m_deviceProxy,
+            &QSortFilterProxyModel::setFilterFixedString);
+    // 设备数放在状态栏右侧的常驻标签中，不覆盖扫描进度与上下线消息
+    m_deviceCountLabel = new QLabel(this);
+    ui->statusbar->addPermanentWidget(m_deviceCountLabel);
+    updateDeviceCount();
+    connect(m_deviceModel, &QAbstractItemModel::rowsInserted, this, &MainWindow::updateDeviceCount);
+    connect(m_deviceModel, &QAbstractItemModel::rowsRemoved, this, &MainWindow::updateDeviceCount);
+    connect(m_deviceModel, &QAbstractItemModel::modelReset, this, &MainWindow::updateDeviceCount);
+
+    QMenu *fileMenu = ui->menubar->addMenu(tr("File"));
+    QAction *exportAction = fileMenu->addAction(tr("Export Devices..."));
+    connect(exportAction, &QAction::triggered, this, &MainWindow::exportDevices);
+
+    // 直接按上次保存的配置开始发现，设置对话框随时可从菜单打开并即时生效
+    m_profiles = new ProfileStore(this);
+    m_profile = m_profiles->current();
+    m_network = new NetworkWorker(this);
+
+    m_settingsDialog = new NetworkSettingsDialog(m_profiles, this);
+    connect(m_settingsDialog, &NetworkSettingsDialog::profileApplied, this, &MainWindow::applyProfile);
+    QAction *settingsAction = ui->menubar->addAction(tr("Settings..."));
+    connect(settingsAction, &QAction::triggered, this, [this]() {
+        m_settingsDialog->show();
+        m_settingsDialog->raise();
+        m_settingsDialog->activateWindow();
+    });
+
+    // 首次运行尚未选择任何发现方式：先打开设置，应用后再开始
+    if (!m_profile.methods.contains(true) && m_profile.targets.isEmpty()) {
+        QTimer::singleShot(0, settingsAction, &QAction::trigger);
+        return;
     }
+    startFinder(m_profile);
+}
+
+void MainWindow::startFinder(const DiscoveryProfile &profile)
+{
+    FINDER_TRACE() << "Profile:" << profile.name << "targets:" << profile.targets
+                   << "methods:" << profile.methods << "tcp port:" << profile.tcpPort
+                   << "udp port:" << profile.udpPort << "target port:" << profile.targetUdpPort
+                   << "send rate:" << profile.sendRate << "continuous:" << profile.continuous;
+
+    // 发现与监听全部在网络线程中运行，界面线程只接收队列信号
+    finder = new DeviceFinder(profile);
+    finder->setLivenessInterval(profile.continuous ? LIVENESS_INTERVAL_MS : 0);
+    // 设备表变化每 100ms 合并为一批跨线程交给结果表
+    finder->registry()->setBatchInterval(100);
+    m_network->adopt(finder);
+
+    connect(finder, &DeviceFinder::scanProgress, this, [this](quint64 sent, quint64 total) {
+        ui->statusbar->showMessage(tr("Scanning %1 / %2").arg(sent).arg(total));
+    });
+
+    // 持续模式：保留 finder，由设备表事件汇报增减；模式可在运行中切换
+    connect(finder->registry(), &DeviceRegistry::devicesChanged, m_deviceModel,
+            &DeviceTableModel::applyChanges);
+
+    // 在线检测：数秒内发现设备掉线，不必等设备表 60s 过期
+    connect(finder->liveness(), &LivenessMonitor::deviceDown, this,
+            [this](const DeviceAddress &address, qint64 silentUs) {
+        FINDER_TRACE() << "device down:" << address.toHostAddress() << "silent(ms):" << silentUs / 1000;
+        ui->statusbar->showMessage(tr("%1 is down").arg(address.toHostAddress().toString()));
+    });
+    connect(finder->liveness(), &LivenessMonitor::deviceUp, this,
+            [this](const DeviceAddress &address, qint64 srttUs) {
+        FINDER_TRACE() << "device up:" << address.toHostAddress() << "srtt(us):" << srttUs;
+        ui->statusbar->showMessage(tr("%1 is up").arg(address.toHostAddress().toString()));
+    });
+
+    connect(finder, &DeviceFinder::deviceFound, this, [this](QString ip){
+        // 已排队的重复结果在 finder 释放后仍可能到达
+        if (!finder || m_profile.continuous) {
+            return;
+        }
+        FINDER_TRACE() << "deviceFound main:" << ip;
+        // 在网络线程中先交出尚未到期的一批结果再释放，设备表是 finder 的子对象
+        DeviceFinder *done = finder;
+        done->disconnect();
+        QMetaObject::invokeMethod(done, [done]() {
+            done->registry()->flushBatch();
+            done->deleteLater();
+        }, Qt::QueuedConnection);
+        finder = nullptr;
+    });
 
-    finder = new DeviceFinder(method, ipAddress, tcpPort, udpPort, targetUdpPort);
     QTimer::singleShot(0, finder, &DeviceFinder::startDiscovery);
     QTimer::singleShot(0, finder, &DeviceFinder::startListening);
+}
 
-    QTimer::connect(finder, &DeviceFinder::deviceFound, [&](QString ip){
-        qDebug()<< "deviceFound main: " << ip ;
-        finder->disconnect();
-        finder->deleteLater();
-    });
+void MainWindow::updateDeviceCount()
+{
+    m_deviceCountLabel->setText(tr("%1 devices").arg(m_deviceModel->rowCount()));
+}
+
+void MainWindow::exportDevices()
+{
+    const QString path = QFileDialog::getSaveFileName(this, tr("Export Devices"), QString(),
+                                                      tr("CSV (*.csv);;JSON (*.json)"));
+    if (path.isEmpty()) {
+        return;
+    }
+    // 结果表的行已在界面线程，直接逐行写出，不经网络线程也不复制
+    const QVector<DeviceRecord> &records = m_deviceModel->records();
+    QString error;
+    const int count = DeviceExport::writeFile(path, [&records](auto visit) {
+        for (const DeviceRecord &record : records) {
+            visit(record);
+        }
+    }, &error);
+    if (count < 0) {
+        QMessageBox::warning(this, tr("Export Devices"), tr("Export failed: %1").arg(error));
+        return;
+    }
+    ui->statusbar->showMessage(tr("Exported %1 devices to %2").arg(count).arg(path));
+}
+
+void MainWindow::applyProfile(const DiscoveryProfile &profile)
+{
+    m_profile = profile;
+    if (!finder) {
+        // 单次发现已结束（或尚未开始）：按新配置重新发现
+        startFinder(profile);
+        return;
+    }
+    // finder 在网络线程中，配置以队列调用交给它；finder 已释放时调用被丢弃
+    DeviceFinder *target = finder;
+    QMetaObject::invokeMethod(target, [target, profile]() {
+        target->applyProfile(profile);
+        target->setLivenessInterval(profile.continuous ? LIVENESS_INTERVAL_MS : 0);
+    }, Qt::QueuedConnection);
 }
 MainWindow::~MainWindow()
 {
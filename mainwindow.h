@@ -5,6 +5,13 @@
 #include <QApplication>
 #include <QDebug>
 #include "devicefinder.h"
+#include "discoveryprofile.h"
+
+class NetworkWorker;
+class NetworkSettingsDialog;
+class DeviceTableModel;
+class QSortFilterProxyModel;
+class QLabel;
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -20,8 +27,25 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+private slots:
+    // 对话框应用的配置：运行中的 finder 即时更新，已结束时按新配置重新发现
+    void applyProfile(const DiscoveryProfile &profile);
+
+    // 把结果表中的全部设备导出为 CSV 或 JSON（按扩展名）
+    void exportDevices();
+
 private:
-    DeviceFinder *finder;
+    void startFinder(const DiscoveryProfile &profile);
+    void updateDeviceCount();
+
+    DeviceFinder *finder = nullptr;
+    NetworkWorker *m_network = nullptr;
+    ProfileStore *m_profiles = nullptr;
+    NetworkSettingsDialog *m_settingsDialog = nullptr;
+    DiscoveryProfile m_profile;
+    DeviceTableModel *m_deviceModel = nullptr;
+    QSortFilterProxyModel *m_deviceProxy = nullptr;
+    QLabel *m_deviceCountLabel = nullptr;
     Ui::MainWindow *ui;
 };
 #endif // MAINWINDOW_H
@@ -0,0 +1,46 @@
+#include "metricsexporter.h"
+
+#include "discoverymetrics.h"
+
+#include <QTcpSocket>
+#include <QJsonDocument>
+
+MetricsExporter::MetricsExporter(QObject *parent)
+    : QObject(parent)
+{
+    m_server = new QTcpServer(this);
+    connect(m_server, &QTcpServer::newConnection, this, &MetricsExporter::onNewConnection);
+}
+
+bool MetricsExporter::listen(quint16 port, const QHostAddress &address)
+{
+    if (!m_server->listen(address, port)) {
+        qWarning() << "Metrics listen failed:" << m_server->errorString();
+        return false;
+    }
+    return true;
+}
+
+void MetricsExporter::onNewConnection()
+{
+    while (m_server->hasPendingConnections()) {
+        QTcpSocket *client = m_server->nextPendingConnection();
+        connect(client, &QTcpSocket::disconnected, client, &QObject::deleteLater);
+        // 请求内容不关心，收到第一段数据即应答
+        connect(client, &QTcpSocket::readyRead, client, [client]() {
+            client->readAll();
+            if (client->state() != QAbstractSocket::ConnectedState) {
+                return;
+            }
+            const QByteArray body = QJsonDocument(DiscoveryMetrics::instance().snapshot().toJson())
+                                        .toJson(QJsonDocument::Compact);
+            QByteArray response = "HTTP/1.0 200 OK\r\n"
+                                  "Content-Type: application/json\r\n"
+                                  "Connection: close\r\n"
+                                  "Content-Length: " + QByteArray::number(body.size()) + "\r\n\r\n";
+            response += body;
+            client->write(response);
+            client->disconnectFromHost();
+        });
+    }
+}
@@ -0,0 +1,25 @@
+#ifndef METRICSEXPORTER_H
+#define METRICSEXPORTER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QHostAddress>
+
+// 本地指标导出：任意 HTTP 请求都以当前 DiscoveryMetrics 快照（JSON）应答后关闭连接。
+// 默认只监听回环地址
+class MetricsExporter : public QObject {
+    Q_OBJECT
+
+public:
+    explicit MetricsExporter(QObject *parent = nullptr);
+
+    bool listen(quint16 port, const QHostAddress &address = QHostAddress::LocalHost);
+    quint16 port() const { return m_server->serverPort(); }
+
+private:
+    void onNewConnection();
+
+    QTcpServer *m_server;
+};
+
+#endif // METRICSEXPORTER_H
@@ -0,0 +1,109 @@
+#include "neighbortable.h"
+
+#ifdef Q_OS_LINUX
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/neighbour.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+bool Neighbor::isUsable() const
+{
+#ifdef Q_OS_LINUX
+    return (state & (NUD_REACHABLE | NUD_STALE | NUD_DELAY | NUD_PROBE | NUD_PERMANENT)) != 0;
+#else
+    return true;
+#endif
+}
+
+QList<Neighbor> NeighborTable::dump(QAbstractSocket::NetworkLayerProtocol protocol)
+{
+    QList<Neighbor> neighbors;
+#ifdef Q_OS_LINUX
+    const int family = protocol == QAbstractSocket::IPv6Protocol ? AF_INET6 : AF_INET;
+    const int fd = ::socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0) {
+        return neighbors;
+    }
+
+    struct {
+        nlmsghdr header;
+        ndmsg body;
+    } request;
+    std::memset(&request, 0, sizeof(request));
+    request.header.nlmsg_len = NLMSG_LENGTH(sizeof(ndmsg));
+    request.header.nlmsg_type = RTM_GETNEIGH;
+    request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.header.nlmsg_seq = 1;
+    request.body.ndm_family = quint8(family);
+
+    sockaddr_nl kernel;
+    std::memset(&kernel, 0, sizeof(kernel));
+    kernel.nl_family = AF_NETLINK;
+    if (::sendto(fd, &request, request.header.nlmsg_len, 0,
+                 reinterpret_cast<sockaddr *>(&kernel), sizeof(kernel)) < 0) {
+        ::close(fd);
+        return neighbors;
+    }
+
+    alignas(nlmsghdr) char buffer[16384];
+    bool done = false;
+    while (!done) {
+        const ssize_t received = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (received <= 0) {
+            break;
+        }
+        int remaining = int(received);
+        for (nlmsghdr *header = reinterpret_cast<nlmsghdr *>(buffer); NLMSG_OK(header, remaining);
+             header = NLMSG_NEXT(header, remaining)) {
+            if (header->nlmsg_type == NLMSG_DONE || header->nlmsg_type == NLMSG_ERROR) {
+                done = true;
+                break;
+            }
+            if (header->nlmsg_type != RTM_NEWNEIGH) {
+                continue;
+            }
+            const ndmsg *entry = static_cast<const ndmsg *>(NLMSG_DATA(header));
+            if (entry->ndm_family != family) {
+                continue;
+            }
+
+            Neighbor neighbor;
+            neighbor.ifindex = entry->ndm_ifindex;
+            neighbor.state = entry->ndm_state;
+            int length = int(header->nlmsg_len) - int(NLMSG_LENGTH(sizeof(ndmsg)));
+            const rtattr *attribute = reinterpret_cast<const rtattr *>(
+                reinterpret_cast<const char *>(entry) + NLMSG_ALIGN(sizeof(ndmsg)));
+            for (; RTA_OK(attribute, length); attribute = RTA_NEXT(attribute, length)) {
+                const quint8 *data = static_cast<const quint8 *>(RTA_DATA(attribute));
+                const int size = int(RTA_PAYLOAD(attribute));
+                if (attribute->rta_type == NDA_DST) {
+                    if (family == AF_INET && size == 4) {
+                        quint32 be;
+                        std::memcpy(&be, data, 4);
+                        neighbor.address = QHostAddress(ntohl(be));
+                    } else if (family == AF_INET6 && size == 16) {
+                        neighbor.address = QHostAddress(data);
+                        // fe80::/10 需要接口 scope 才能发送
+                        if (data[0] == 0xfe && (data[1] & 0xc0) == 0x80) {
+                            neighbor.address.setScopeId(QString::number(neighbor.ifindex));
+                        }
+                    }
+                } else if (attribute->rta_type == NDA_LLADDR && size == 6) {
+                    neighbor.mac = QByteArray(reinterpret_cast<const char *>(data), size);
+                }
+            }
+            if (!neighbor.address.isNull()) {
+                neighbors.append(neighbor);
+            }
+        }
+    }
+    ::close(fd);
+#else
+    Q_UNUSED(protocol);
+#endif
+    return neighbors;
+}
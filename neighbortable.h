@@ -0,0 +1,25 @@
+#ifndef NEIGHBORTABLE_H
+#define NEIGHBORTABLE_H
+
+#include <QHostAddress>
+#include <QByteArray>
+#include <QList>
+
+struct Neighbor {
+    QHostAddress address;   // IPv6 链路本地地址带接口 scope
+    int ifindex = 0;
+    QByteArray mac;         // 未解析时为空
+    quint16 state = 0;      // 内核 NUD_* 状态位
+
+    // 内核认为可达或最近可达（REACHABLE / STALE / DELAY / PROBE / PERMANENT）
+    bool isUsable() const;
+};
+
+// 内核邻居表（IPv4 ARP、IPv6 NDP）的快照，Linux 上通过 netlink RTM_GETNEIGH 读取
+class NeighborTable {
+public:
+    // protocol 为 IPv4Protocol 或 IPv6Protocol；非 Linux 或读取失败时返回空
+    static QList<Neighbor> dump(QAbstractSocket::NetworkLayerProtocol protocol);
+};
+
+#endif // NEIGHBORTABLE_H
@@ -10,56 +10,177 @@
 #include <QGroupBox>
 #include <QHBoxLayout>
 #include <QPushButton>
-#include <QSettings>
-#include <QRegularExpressionValidator>
+#include <QComboBox>
+#include <QInputDialog>
+#include <QMessageBox>
+#include <QShowEvent>
+#include <QValidator>
+#include <QRegularExpression>
 #include "devicefinder.h"
+#include "targetspec.h"
+#include "discoveryprofile.h"
+
+// 目标列表输入：能被 TargetSpec 完整解析时可接受，输入中途只含地址字符时视为未完成
+class TargetSpecValidator : public QValidator {
+public:
+    explicit TargetSpecValidator(QObject *parent = nullptr) : QValidator(parent) {}
+
+    State validate(QString &input, int &pos) const override {
+        Q_UNUSED(pos);
+        static const QRegularExpression allowed(QStringLiteral("^[0-9./,;\\s-]*$"));
+        if (!allowed.match(input).hasMatch()) {
+            return Invalid;
+        }
+        IntervalSet targets;
+        return TargetSpec::parse(input, &targets) ? Acceptable : Intermediate;
+    }
+};
 
 class NetworkSettingsDialog : public QDialog {
     Q_OBJECT
 
 public:
-    explicit NetworkSettingsDialog(QWidget *parent = nullptr) : QDialog(parent) {
+    // 非模态使用：show() 后可随时修改，Apply / OK 通过 profileApplied 通知运行中的发现
+    explicit NetworkSettingsDialog(ProfileStore *store, QWidget *parent = nullptr)
+        : QDialog(parent), m_store(store) {
         setupUI();
         setupValidations();
-        loadSettings();
+        reloadProfiles();
         connectSignals();
     }
 
-    // 获取配置参数的访问方法
-    QString ipAddress() const { return m_ipEdit->text().trimmed(); }
-    QVector<bool> broadcastMethods() const {
-        return {m_method1Check->isChecked(),
-                m_method2Check->isChecked(),
-                m_method3Check->isChecked()};
+    // 当前表单内容，名称取自配置下拉框
+    DiscoveryProfile profile() const {
+        DiscoveryProfile profile;
+        profile.name = m_profileCombo->currentText();
+        profile.targets = m_ipEdit->text().trimmed();
+        profile.methods = {m_method1Check->isChecked(),
+                           m_method2Check->isChecked(),
+                           m_method3Check->isChecked(),
+                           m_method4Check->isChecked()};
+        profile.tcpPort = static_cast<quint16>(m_tcpPortSpin->value());
+        profile.udpPort = static_cast<quint16>(m_udpPortSpin->value());
+        profile.targetUdpPort = static_cast<quint16>(m_targetUdpSpin->value());
+        profile.sendRate = m_frequencySpin->value();
+        profile.continuous = m_continuousCheck->isChecked();
+        return profile;
+    }
+
+    void setProfile(const DiscoveryProfile &profile) {
+        m_ipEdit->setText(profile.targets);
+        m_method1Check->setChecked(profile.methods.value(0));
+        m_method2Check->setChecked(profile.methods.value(1));
+        m_method3Check->setChecked(profile.methods.value(2));
+        m_method4Check->setChecked(profile.methods.value(3));
+        m_tcpPortSpin->setValue(profile.tcpPort);
+        m_udpPortSpin->setValue(profile.udpPort);
+        m_targetUdpSpin->setValue(profile.targetUdpPort);
+        m_frequencySpin->setValue(profile.sendRate);
+        m_continuousCheck->setChecked(profile.continuous);
     }
-    quint16 tcpPort() const { return static_cast<quint16>(m_tcpPortSpin->value()); }
-    quint16 udpPort() const { return static_cast<quint16>(m_udpPortSpin->value()); }
-    quint16 targetUdpPort() const { return static_cast<quint16>(m_targetUdpSpin->value()); }
-    int frequency() const { return m_frequencySpin->value(); }
 
 protected:
     void accept() override {
-        if (validateInput()) {
-            saveSettings();
+        if (applyProfile()) {
             QDialog::accept();
         }
     }
 
+    void showEvent(QShowEvent *event) override {
+        // 取消后再次打开时丢弃未应用的修改
+        if (!event->spontaneous()) {
+            reloadProfiles();
+        }
+        QDialog::showEvent(event);
+    }
+
 private slots:
     void onApply() {
-        if (validateInput()) {
-            saveSettings();
-            emit settingsApplied();
+        applyProfile();
+    }
+
+    void onProfileSelected(const QString &name) {
+        if (m_store->contains(name)) {
+            setProfile(m_store->profile(name));
+        }
+    }
+
+    void onSaveAs() {
+        bool ok = false;
+        const QString name = QInputDialog::getText(this, tr("Save Profile"), tr("Profile name:"),
+                                                   QLineEdit::Normal, QString(), &ok);
+        if (!ok) {
+            return;
         }
+        if (!ProfileStore::isValidName(name)) {
+            QMessageBox::warning(this, tr("Save Profile"), tr("Invalid profile name"));
+            return;
+        }
+        if (!validateInput()) {
+            return;
+        }
+        DiscoveryProfile profile = this->profile();
+        profile.name = name;
+        m_store->save(profile);
+        selectProfile(name);
+    }
+
+    void onDelete() {
+        const QString name = m_profileCombo->currentText();
+        if (m_store->names().size() <= 1) {
+            return;
+        }
+        if (QMessageBox::question(this, tr("Delete Profile"), tr("Delete profile \"%1\"?").arg(name))
+            != QMessageBox::Yes) {
+            return;
+        }
+        m_store->remove(name);
+        selectProfile(m_store->currentName());
     }
 
 signals:
-    void settingsApplied();
+    void profileApplied(const DiscoveryProfile &profile);
 
 private:
+    bool applyProfile() {
+        if (!validateInput()) {
+            return false;
+        }
+        const DiscoveryProfile profile = this->profile();
+        m_store->save(profile);
+        m_store->setCurrent(profile.name);
+        emit profileApplied(profile);
+        return true;
+    }
+
+    void reloadProfiles() {
+        selectProfile(m_store->currentName());
+    }
+
+    void selectProfile(const QString &name) {
+        const QSignalBlocker blocker(m_profileCombo);
+        m_profileCombo->clear();
+        m_profileCombo->addItems(m_store->names());
+        m_profileCombo->setCurrentText(name);
+        setProfile(m_store->profile(name));
+        m_deleteButton->setEnabled(m_store->names().size() > 1);
+    }
+
     void setupUI() {
         QVBoxLayout *mainLayout = new QVBoxLayout(this);
 
+        // 配置选择
+        QHBoxLayout *profileLayout = new QHBoxLayout;
+        m_profileCombo = new QComboBox(this);
+        QPushButton *saveAsButton = new QPushButton(tr("Save As..."), this);
+        m_deleteButton = new QPushButton(tr("Delete"), this);
+        profileLayout->addWidget(m_profileCombo, 1);
+        profileLayout->addWidget(saveAsButton);
+        profileLayout->addWidget(m_deleteButton);
+        mainLayout->addLayout(profileLayout);
+        connect(saveAsButton, &QPushButton::clicked, this, &NetworkSettingsDialog::onSaveAs);
+        connect(m_deleteButton, &QPushButton::clicked, this, &NetworkSettingsDialog::onDelete);
+
         // 配置表单区域
         QFormLayout *formLayout = new QFormLayout;
         setupFormFields(formLayout);
@@ -75,7 +196,7 @@ private:
     void setupFormFields(QFormLayout *layout) {
         // IP地址
         m_ipEdit = new QLineEdit(this);
-        layout->addRow(tr("IP Address:"), m_ipEdit);
+        layout->addRow(tr("Targets:"), m_ipEdit);
 
         // 广播方法
         QGroupBox *methodGroup = new QGroupBox(tr("Broadcast Methods"), this);
@@ -83,9 +204,11 @@ private:
         m_method1Check = new QCheckBox(tr("Method 1"), methodGroup);
         m_method2Check = new QCheckBox(tr("Method 2"), methodGroup);
         m_method3Check = new QCheckBox(tr("Method 3"), methodGroup);
+        m_method4Check = new QCheckBox(tr("Method 4 (IPv6)"), methodGroup);
         methodLayout->addWidget(m_method1Check);
         methodLayout->addWidget(m_method2Check);
         methodLayout->addWidget(m_method3Check);
+        methodLayout->addWidget(m_method4Check);
         methodGroup->setLayout(methodLayout);
         layout->addRow(methodGroup);
 
@@ -93,24 +216,27 @@ private:
         m_tcpPortSpin = createPortSpinBox(TCP_LISTEN_PORT);
         m_udpPortSpin = createPortSpinBox(UDP_LISTEN_PORT);
         m_targetUdpSpin = createPortSpinBox(UDP_TARGET_PORT);
-        qDebug() << "UDP_TARGET_PORT: " << UDP_TARGET_PORT;
         layout->addRow(tr("TCP Listen Port:"), m_tcpPortSpin);
         layout->addRow(tr("UDP Listen Port:"), m_udpPortSpin);
         layout->addRow(tr("Target UDP Port:"), m_targetUdpSpin);
 
-        // 发送频率
+        // 发送速率（每秒探测包数）
         m_frequencySpin = new QSpinBox(this);
-        m_frequencySpin->setRange(1, 1000);
-        m_frequencySpin->setValue(100);
-        m_frequencySpin->setSuffix(tr(" ms"));
-        layout->addRow(tr("Send Frequency:"), m_frequencySpin);
+        m_frequencySpin->setRange(1, 100000);
+        m_frequencySpin->setValue(1000);
+        m_frequencySpin->setSuffix(tr(" pkt/s"));
+        layout->addRow(tr("Send Rate:"), m_frequencySpin);
+
+        // 持续发现：找到第一个设备后继续维护设备表
+        m_continuousCheck = new QCheckBox(tr("Continuous Discovery"), this);
+        layout->addRow(m_continuousCheck);
     }
 
     void setupButtonBox(QLayout *layout) {
         QDialogButtonBox *buttonBox = new QDialogButtonBox(this);
         QPushButton *applyBtn = buttonBox->addButton(tr("Apply"), QDialogButtonBox::ApplyRole);
         buttonBox->addButton(QDialogButtonBox::Ok);
-        buttonBox->addButton(QDialogButtonBox::Cancel);
+        buttonBox->addButton(QDialogButtonBox::Close);
 
         connect(buttonBox, &QDialogButtonBox::accepted, this, &QDialog::accept);
         connect(buttonBox, &QDialogButtonBox::rejected, this, &QDialog::reject);
@@ -121,6 +247,7 @@ private:
 
     void connectSignals() {
         // 输入变化时自动验证
+        connect(m_profileCombo, &QComboBox::currentTextChanged, this, &NetworkSettingsDialog::onProfileSelected);
         connect(m_ipEdit, &QLineEdit::textChanged, this, [this]{ validateInput(); });
         connect(m_tcpPortSpin, QOverload<int>::of(&QSpinBox::valueChanged), this, [this]{ validateInput(); });
     }
@@ -131,7 +258,7 @@ private:
 
         // IP地址验证（允许空值）
         if (!ip.isEmpty() && !m_ipEdit->hasAcceptableInput()) {
-            m_ipEdit->setToolTip(tr("Invalid IPv4 address format"));
+            m_ipEdit->setToolTip(tr("Expected IPv4 hosts, ranges or CIDR blocks, e.g. 10.1.4.0/24, 10.1.9.17"));
             isValid = false;
         } else {
             m_ipEdit->setToolTip("");
@@ -140,7 +267,8 @@ private:
         // 至少选择一个广播方法
         if (!m_method1Check->isChecked() &&
             !m_method2Check->isChecked() &&
-            !m_method3Check->isChecked()) {
+            !m_method3Check->isChecked() &&
+            !m_method4Check->isChecked()) {
             m_method1Check->setToolTip(tr("At least one method must be selected"));
             isValid = false;
         } else {
@@ -158,45 +286,25 @@ private:
     }
 
     void setupValidations() {
-        // IPv4验证（允许空值）
-        QRegularExpression ipRegex("^$|^((25[0-5]|2[0-4][0-9]|[01]?[0-9][0-9]?)\\.){3}"
-                                   "(25[0-5]|2[0-4][0-9]|[01]?[0-9][0-9]?)$");
-        QRegularExpressionValidator *ipValidator = new QRegularExpressionValidator(ipRegex, this);
-        m_ipEdit->setValidator(ipValidator);
-    }
-
-    void loadSettings() {
-        QSettings settings;
-        m_ipEdit->setText(settings.value("Network/IP").toString());
-        m_method1Check->setChecked(settings.value("Network/Method1", false).toBool());
-        m_method2Check->setChecked(settings.value("Network/Method2", false).toBool());
-        m_method3Check->setChecked(settings.value("Network/Method3", false).toBool());
-        m_tcpPortSpin->setValue(settings.value("Network/TCPPort", TCP_LISTEN_PORT).toInt());
-        m_udpPortSpin->setValue(settings.value("Network/UDPPort", UDP_LISTEN_PORT).toInt());
-        m_targetUdpSpin->setValue(settings.value("Network/TargetUDP", UDP_TARGET_PORT).toInt());
-        m_frequencySpin->setValue(settings.value("Network/Frequency", 100).toInt());
-    }
-
-    void saveSettings() {
-        QSettings settings;
-        settings.setValue("Network/IP", m_ipEdit->text());
-        settings.setValue("Network/Method1", m_method1Check->isChecked());
-        settings.setValue("Network/Method2", m_method2Check->isChecked());
-        settings.setValue("Network/Method3", m_method3Check->isChecked());
-        settings.setValue("Network/TCPPort", m_tcpPortSpin->value());
-        settings.setValue("Network/UDPPort", m_udpPortSpin->value());
-        settings.setValue("Network/TargetUDP", m_targetUdpSpin->value());
-        settings.setValue("Network/Frequency", m_frequencySpin->value());
+        // 目标列表验证（允许空值）：主机、区间与 CIDR 网段，逗号分隔
+        m_ipEdit->setValidator(new TargetSpecValidator(this));
+        m_ipEdit->setPlaceholderText(tr("10.1.4.0/24, 10.1.9.17, 10.2.0.0/20"));
     }
 
+    ProfileStore *m_store;
+
     // 成员变量命名添加m_前缀
+    QComboBox *m_profileCombo;
+    QPushButton *m_deleteButton;
     QLineEdit *m_ipEdit;
     QCheckBox *m_method1Check;
     QCheckBox *m_method2Check;
     QCheckBox *m_method3Check;
+    QCheckBox *m_method4Check;
     QSpinBox *m_tcpPortSpin;
     QSpinBox *m_udpPortSpin;
     QSpinBox *m_targetUdpSpin;
     QSpinBox *m_frequencySpin;
+    QCheckBox *m_continuousCheck;
 };
 #endif // NETWORKSETTINGSDIALOGH_H
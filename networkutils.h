@@ -0,0 +1,118 @@
+#ifndef NETWORKUTILS_H
+#define NETWORKUTILS_H
+
+#include <QNetworkInterface>
+#include <QHostAddress>
+#include <QFile>
+#include <QPair>
+#include <QList>
+
+class NetworkUtils {
+public:
+    static QPair<QHostAddress,QHostAddress> getLocalIp() {
+        foreach (const QNetworkInterface &interface, QNetworkInterface::allInterfaces()) {
+            // 跳过未启用或未运行的接口
+            if (!interface.flags().testFlag(QNetworkInterface::IsUp) ||
+                !interface.flags().testFlag(QNetworkInterface::IsRunning)) {
+                continue;
+            }
+
+            // 检查接口类型：有线或无线
+            bool isWired = (interface.type() == QNetworkInterface::Ethernet);
+            bool isWireless = (interface.type() == QNetworkInterface::Ieee80211);
+            if (!isWired && !isWireless) {
+                continue;
+            }
+
+            // 排除名称包含虚拟设备或蓝牙的接口
+            QString ifaceName = interface.humanReadableName();
+            if (ifaceName.contains("VMware", Qt::CaseInsensitive) ||
+                ifaceName.contains("Bluetooth", Qt::CaseInsensitive)) {
+                continue;
+            }
+            foreach (const QNetworkAddressEntry &entry, interface.addressEntries()) {
+                if (!entry.ip().isLoopback() && entry.ip().protocol() == QAbstractSocket::IPv4Protocol) {
+                    return QPair<QHostAddress, QHostAddress>{entry.ip(), entry.netmask()};
+                }
+            }
+        }
+        return QPair<QHostAddress, QHostAddress>{QHostAddress::LocalHost, QHostAddress::LocalHost};
+    }
+
+    static QList<QNetworkInterface> getValidInterfaces() {
+        QList<QNetworkInterface> validInterfaces;
+        foreach (const QNetworkInterface &interface, QNetworkInterface::allInterfaces()) {
+            if (interface.flags() & QNetworkInterface::IsUp &&
+                !(interface.flags() & QNetworkInterface::IsLoopBack)) {
+                    validInterfaces.append(interface);
+                }
+        }
+        return validInterfaces;
+    }
+
+    // 所有有效网卡上的 IPv4 地址（带子网掩码），每个网段一项
+    static QList<QNetworkAddressEntry> getLocalSubnets() {
+        QList<QNetworkAddressEntry> subnets;
+        foreach (const QNetworkInterface &interface, getValidInterfaces()) {
+            if (!interface.flags().testFlag(QNetworkInterface::IsRunning)) {
+                continue;
+            }
+            foreach (const QNetworkAddressEntry &entry, interface.addressEntries()) {
+                if (entry.ip().protocol() == QAbstractSocket::IPv4Protocol &&
+                    !entry.ip().isLoopback() && entry.prefixLength() < 31) {
+                    subnets.append(entry);
+                }
+            }
+        }
+        return subnets;
+    }
+
+    // 运行中、支持组播且带 IPv6 地址的有效网卡，用于链路本地组播探测
+    static QList<QNetworkInterface> getIpv6Interfaces() {
+        QList<QNetworkInterface> interfaces;
+        foreach (const QNetworkInterface &interface, getValidInterfaces()) {
+            if (!interface.flags().testFlag(QNetworkInterface::IsRunning) ||
+                !interface.flags().testFlag(QNetworkInterface::CanMulticast)) {
+                continue;
+            }
+            foreach (const QNetworkAddressEntry &entry, interface.addressEntries()) {
+                if (entry.ip().protocol() == QAbstractSocket::IPv6Protocol) {
+                    interfaces.append(interface);
+                    break;
+                }
+            }
+        }
+        return interfaces;
+    }
+
+    // 从内核 ARP 表查询 IPv4 地址对应的 MAC（仅 Linux），未知时返回空
+    static QByteArray macForAddress(const QHostAddress &address) {
+        QByteArray mac;
+#ifdef Q_OS_LINUX
+        bool ok = false;
+        const QHostAddress ipv4(address.toIPv4Address(&ok));
+        QFile arp(QStringLiteral("/proc/net/arp"));
+        if (!ok || !arp.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            return mac;
+        }
+        const QByteArray ip = ipv4.toString().toLatin1();
+        arp.readLine(); // 表头
+        while (!arp.atEnd()) {
+            // IP address  HW type  Flags  HW address  Mask  Device
+            const QList<QByteArray> fields = arp.readLine().simplified().split(' ');
+            if (fields.size() >= 4 && fields[0] == ip) {
+                mac = QByteArray::fromHex(QByteArray(fields[3]).replace(':', ""));
+                if (mac.size() != 6 || mac == QByteArray(6, '\0')) {
+                    mac.clear();
+                }
+                break;
+            }
+        }
+#else
+        Q_UNUSED(address);
+#endif
+        return mac;
+    }
+};
+
+#endif // NETWORKUTILS_H
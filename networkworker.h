@@ -0,0 +1,36 @@
+#ifndef NETWORKWORKER_H
+#define NETWORKWORKER_H
+
+#include <QObject>
+#include <QThread>
+
+// 网络 I/O 专用线程：DeviceFinder / ConnectionHandler 的监听移入该线程运行，
+// 结果通过跨线程（队列）信号交给界面线程
+class NetworkWorker : public QObject {
+    Q_OBJECT
+
+public:
+    explicit NetworkWorker(QObject *parent = nullptr) : QObject(parent) {
+        m_thread = new QThread(this);
+        m_thread->setObjectName(QStringLiteral("FinderNetwork"));
+        m_thread->start();
+    }
+
+    ~NetworkWorker() override {
+        m_thread->quit();
+        m_thread->wait();
+    }
+
+    // 对象必须没有 parent；线程结束时在网络线程内释放
+    void adopt(QObject *object) {
+        object->moveToThread(m_thread);
+        connect(m_thread, &QThread::finished, object, &QObject::deleteLater);
+    }
+
+    QThread *workerThread() const { return m_thread; }
+
+private:
+    QThread *m_thread;
+};
+
+#endif // NETWORKWORKER_H
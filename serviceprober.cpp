@@ -0,0 +1,229 @@
+#include "serviceprober.h"
+#include "discoverymetrics.h"
+
+#include <QTcpSocket>
+
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+// 超时时间轮的节拍
+constexpr int SERVICE_TICK_MS = 50;
+constexpr int SERVICE_WHEEL_SLOTS = 128;
+
+ServiceProber::ServiceProber(QObject *parent)
+    : QObject(parent)
+    , m_timeouts(SERVICE_WHEEL_SLOTS)
+{
+    qRegisterMetaType<DeviceAddress>("DeviceAddress");
+    qRegisterMetaType<QVector<quint16>>("QVector<quint16>");
+    m_tickTimer = new QTimer(this);
+    m_tickTimer->setInterval(SERVICE_TICK_MS);
+    connect(m_tickTimer, &QTimer::timeout, this, &ServiceProber::onTick);
+    setMaxInFlight(m_maxInFlight);
+}
+
+ServiceProber::~ServiceProber()
+{
+    clear();
+}
+
+void ServiceProber::setPorts(const QVector<quint16> &ports)
+{
+    m_ports = ports;
+    std::sort(m_ports.begin(), m_ports.end());
+    m_ports.erase(std::unique(m_ports.begin(), m_ports.end()), m_ports.end());
+    m_ports.removeAll(0);
+}
+
+void ServiceProber::setMaxInFlight(int count)
+{
+    m_maxInFlight = qMax(1, count);
+#ifdef Q_OS_UNIX
+    // 留一半描述符给监听、扫描等套接字
+    rlimit limit;
+    if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY) {
+        m_maxInFlight = qMin(m_maxInFlight, qMax(1, int(limit.rlim_cur / 2)));
+    }
+#endif
+}
+
+void ServiceProber::setTimeout(int ms)
+{
+    m_timeoutTicks = qMax(1, (ms + SERVICE_TICK_MS - 1) / SERVICE_TICK_MS);
+}
+
+void ServiceProber::enqueue(const DeviceAddress &address)
+{
+    if (address.isNull() || m_ports.isEmpty() || m_hosts.contains(address)) {
+        return;
+    }
+    Host &host = m_hosts[address];
+    host.ports = m_ports;
+    host.queued = true;
+    m_ready.enqueue(address);
+    pump();
+}
+
+void ServiceProber::cancel(const DeviceAddress &address)
+{
+    if (m_hosts.remove(address) == 0) {
+        return;
+    }
+    // m_ready 中的残留项在 pump() 中按哈希表判断丢弃
+    for (auto it = m_attempts.begin(); it != m_attempts.end();) {
+        if (it->address == address) {
+            m_timeouts.cancel(it.key());
+            release(*it);
+            it = m_attempts.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    pump();
+}
+
+void ServiceProber::clear()
+{
+    for (auto it = m_attempts.begin(); it != m_attempts.end(); ++it) {
+        m_timeouts.cancel(it.key());
+        release(*it);
+    }
+    m_attempts.clear();
+    m_hosts.clear();
+    m_ready.clear();
+    m_tickTimer->stop();
+}
+
+void ServiceProber::pump()
+{
+    while (m_attempts.size() < m_maxInFlight && !m_ready.isEmpty()) {
+        const DeviceAddress address = m_ready.dequeue();
+        auto it = m_hosts.find(address);
+        if (it == m_hosts.end() || !it->queued) {
+            continue;
+        }
+        it->queued = false;
+        if (it->next >= it->ports.size() || it->inFlight >= m_maxPerHost) {
+            continue;
+        }
+        ++it->inFlight;
+        const quint16 port = it->ports.at(it->next++);
+        // 每次只为一台设备发起一个连接，再排到队尾，保证各设备轮流推进
+        if (it->next < it->ports.size() && it->inFlight < m_maxPerHost) {
+            it->queued = true;
+            m_ready.enqueue(address);
+        }
+        launch(address, port);
+    }
+    if (!m_attempts.isEmpty() && !m_tickTimer->isActive()) {
+        m_tickTimer->start();
+    }
+}
+
+void ServiceProber::launch(const DeviceAddress &address, quint16 port)
+{
+    const quint32 id = ++m_nextId;
+    QTcpSocket *socket = new QTcpSocket(this);
+    Attempt &attempt = m_attempts[id];
+    attempt.address = address;
+    attempt.port = port;
+    attempt.socket = socket;
+    m_timeouts.schedule(id, m_timeoutTicks);
+    countMetric(MetricCounter::ServiceConnects);
+
+    connect(socket, &QTcpSocket::connected, this, [this, id]() { finish(id, true); });
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    connect(socket, &QTcpSocket::errorOccurred, this, [this, id]() { finish(id, false); });
+#else
+    connect(socket, QOverload<QAbstractSocket::SocketError>::of(&QTcpSocket::error),
+            this, [this, id]() { finish(id, false); });
+#endif
+    // 地址是数值形式，不经过域名解析；connect 在事件循环中异步完成
+    socket->connectToHost(address.toHostAddress(), port);
+}
+
+void ServiceProber::finish(quint32 id, bool open)
+{
+    auto attemptIt = m_attempts.find(id);
+    if (attemptIt == m_attempts.end()) {
+        return;
+    }
+    const DeviceAddress address = attemptIt->address;
+    const quint16 port = attemptIt->port;
+    m_timeouts.cancel(id);
+    release(*attemptIt);
+    m_attempts.erase(attemptIt);
+
+    auto it = m_hosts.find(address);
+    if (it != m_hosts.end()) {
+        --it->inFlight;
+        if (open) {
+            countMetric(MetricCounter::ServicePortsOpen);
+            it->open.append(port);
+        }
+        if (it->next < it->ports.size()) {
+            if (!it->queued) {
+                it->queued = true;
+                m_ready.enqueue(address);
+            }
+        } else if (it->inFlight == 0) {
+            QVector<quint16> openPorts = it->open;
+            m_hosts.erase(it);
+            std::sort(openPorts.begin(), openPorts.end());
+            FINDER_TRACE() << "Services of" << address.toHostAddress() << openPorts;
+            emit hostProbed(address, openPorts);
+        }
+    }
+    pump();
+    if (m_attempts.isEmpty()) {
+        m_tickTimer->stop();
+    }
+}
+
+void ServiceProber::release(Attempt &attempt)
+{
+    // 先断开信号，abort() 不再回调 finish()
+    attempt.socket->disconnect(this);
+    attempt.socket->abort();
+    attempt.socket->deleteLater();
+    attempt.socket = nullptr;
+}
+
+void ServiceProber::onTick()
+{
+    QVector<quint32> expired;
+    m_timeouts.advance([&expired](quint32 id) { expired.append(id); });
+    for (quint32 id : expired) {
+        // 无应答（被过滤）按关闭处理
+        countMetric(MetricCounter::ServiceTimeouts);
+        finish(id, false);
+    }
+}
+
+bool ServiceProber::parsePorts(const QString &spec, QVector<quint16> *ports, QString *error)
+{
+    const QStringList items = spec.split(QLatin1Char(','), Qt::SkipEmptyParts);
+    for (const QString &raw : items) {
+        const QString item = raw.trimmed();
+        const int dash = item.indexOf(QLatin1Char('-'));
+        bool okFirst = false;
+        bool okLast = false;
+        const uint first = (dash < 0 ? item : item.left(dash)).trimmed().toUInt(&okFirst);
+        const uint last = dash < 0 ? first : item.mid(dash + 1).trimmed().toUInt(&okLast);
+        if (!okFirst || (dash >= 0 && !okLast) || first == 0 || last > 65535 || first > last) {
+            if (error) {
+                *error = QStringLiteral("invalid port or range \"%1\"").arg(item);
+            }
+            return false;
+        }
+        for (uint port = first; port <= last; ++port) {
+            ports->append(quint16(port));
+        }
+    }
+    std::sort(ports->begin(), ports->end());
+    ports->erase(std::unique(ports->begin(), ports->end()), ports->end());
+    return true;
+}
@@ -0,0 +1,89 @@
+#ifndef SERVICEPROBER_H
+#define SERVICEPROBER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QHash>
+#include <QQueue>
+#include <QVector>
+
+#include "deviceaddress.h"
+#include "timerwheel.h"
+
+class QTcpSocket;
+
+// 已发现设备的服务探测：对端口列表逐个发起非阻塞 TCP connect，连上即为开放。
+// 全局与每台设备的并发连接数都有上限，连接完成、被拒或超时后立即关闭，
+// 因此占用的描述符数不超过全局上限；各设备轮流发起连接，不会被单台设备占满。
+// 连接超时挂在一个时间轮上，由一个定时器驱动
+class ServiceProber : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ServiceProber(QObject *parent = nullptr);
+    ~ServiceProber() override;
+
+    // 待探测的端口，只影响之后加入的设备；为空时 enqueue() 不做任何事
+    void setPorts(const QVector<quint16> &ports);
+    const QVector<quint16> &ports() const { return m_ports; }
+
+    // 同时进行的连接上限，不超过进程描述符上限的一半
+    void setMaxInFlight(int count);
+    void setMaxPerHost(int count) { m_maxPerHost = qMax(1, count); }
+    void setTimeout(int ms);
+
+    // 加入探测队列；已在队列中的设备忽略
+    void enqueue(const DeviceAddress &address);
+    // 放弃该设备尚未完成的探测，不发出 hostProbed
+    void cancel(const DeviceAddress &address);
+    void clear();
+
+    int pending() const { return m_hosts.size(); }
+    int inFlight() const { return m_attempts.size(); }
+
+    // 解析 "80,443,8000-8100" 形式的端口列表，结果升序去重
+    static bool parsePorts(const QString &spec, QVector<quint16> *ports, QString *error = nullptr);
+
+signals:
+    // 一台设备的全部端口探测完毕，openPorts 升序
+    void hostProbed(const DeviceAddress &address, const QVector<quint16> &openPorts);
+
+private slots:
+    void onTick();
+
+private:
+    struct Host {
+        QVector<quint16> ports;     // 加入时的端口列表快照
+        QVector<quint16> open;
+        int next = 0;
+        int inFlight = 0;
+        bool queued = false;        // 是否在 m_ready 中
+    };
+
+    struct Attempt {
+        DeviceAddress address;
+        quint16 port = 0;
+        QTcpSocket *socket = nullptr;
+    };
+
+    // 在全局上限内按轮转顺序为各设备发起连接
+    void pump();
+    void launch(const DeviceAddress &address, quint16 port);
+    void finish(quint32 id, bool open);
+    void release(Attempt &attempt);
+
+    QVector<quint16> m_ports;
+    int m_maxInFlight = 256;
+    int m_maxPerHost = 4;
+    int m_timeoutTicks = 20;
+
+    QHash<DeviceAddress, Host> m_hosts;
+    QQueue<DeviceAddress> m_ready;      // 还有端口未发起且未达单机上限的设备
+    QHash<quint32, Attempt> m_attempts;
+    quint32 m_nextId = 0;
+
+    TimerWheel<quint32> m_timeouts;
+    QTimer *m_tickTimer;
+};
+
+#endif // SERVICEPROBER_H
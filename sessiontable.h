@@ -0,0 +1,153 @@
+#ifndef SESSIONTABLE_H
+#define SESSIONTABLE_H
+
+#include <QVector>
+
+#include "deviceaddress.h"
+
+// 对端会话
+struct PeerSession {
+    DeviceAddress address;
+    qint64 firstSeenUs = 0;     // SubnetSweeper::clockUs
+    qint64 lastSeenUs = 0;
+    quint32 messages = 0;
+};
+
+// 按对端地址索引的会话表：开放寻址、线性探测，所有会话存放在一块连续数组中，
+// 查找只访问相邻的几项，不为每个对端分配节点。删除用后移法补位，不留墓碑。
+// 不加锁，每个服务线程各持有一张
+class SessionTable {
+public:
+    explicit SessionTable(int capacity = 1024) { m_slots.resize(roundUp(capacity)); }
+
+    // 记录一次来自 address 的消息，返回 true 表示新会话
+    bool touch(const DeviceAddress &address, qint64 nowUs) {
+        if ((m_size + 1) * 4 > m_slots.size() * 3) {
+            rehash(m_slots.size() * 2);
+        }
+        const int mask = m_slots.size() - 1;
+        for (int i = int(qHash(address)) & mask;; i = (i + 1) & mask) {
+            Slot &slot = m_slots[i];
+            if (!slot.used) {
+                slot.used = true;
+                slot.session.address = address;
+                slot.session.firstSeenUs = nowUs;
+                slot.session.lastSeenUs = nowUs;
+                slot.session.messages = 1;
+                ++m_size;
+                return true;
+            }
+            if (slot.session.address == address) {
+                slot.session.lastSeenUs = nowUs;
+                ++slot.session.messages;
+                return false;
+            }
+        }
+    }
+
+    const PeerSession *find(const DeviceAddress &address) const {
+        const int index = indexOf(address);
+        return index < 0 ? nullptr : &m_slots.at(index).session;
+    }
+
+    bool remove(const DeviceAddress &address) {
+        const int index = indexOf(address);
+        if (index < 0) {
+            return false;
+        }
+        erase(index);
+        return true;
+    }
+
+    // 删除 lastSeenUs 早于 cutoffUs 的会话，对每个删除的会话调用 expired(session)
+    template <typename Callback>
+    int expire(qint64 cutoffUs, Callback expired) {
+        int removed = 0;
+        for (int i = 0; i < m_slots.size();) {
+            if (m_slots.at(i).used && m_slots.at(i).session.lastSeenUs < cutoffUs) {
+                const PeerSession session = m_slots.at(i).session;
+                // 后移补位可能把未检查的项移到 i，因此不前进
+                erase(i);
+                expired(session);
+                ++removed;
+            } else {
+                ++i;
+            }
+        }
+        return removed;
+    }
+
+    void clear() {
+        m_slots.fill(Slot());
+        m_size = 0;
+    }
+
+    int size() const { return m_size; }
+
+private:
+    struct Slot {
+        PeerSession session;
+        bool used = false;
+    };
+
+    static int roundUp(int capacity) {
+        int size = 16;
+        while (size < capacity) {
+            size *= 2;
+        }
+        return size;
+    }
+
+    int indexOf(const DeviceAddress &address) const {
+        const int mask = m_slots.size() - 1;
+        for (int i = int(qHash(address)) & mask;; i = (i + 1) & mask) {
+            const Slot &slot = m_slots.at(i);
+            if (!slot.used) {
+                return -1;
+            }
+            if (slot.session.address == address) {
+                return i;
+            }
+        }
+    }
+
+    // 后移删除：把探测链上后续可以前移的项填入空位，保持查找链连续
+    void erase(int index) {
+        const int mask = m_slots.size() - 1;
+        int hole = index;
+        for (int i = (hole + 1) & mask; m_slots.at(i).used; i = (i + 1) & mask) {
+            const int home = int(qHash(m_slots.at(i).session.address)) & mask;
+            // home 不在 (hole, i] 之间时该项可以移到空位
+            const bool between = hole <= i ? (home > hole && home <= i) : (home > hole || home <= i);
+            if (!between) {
+                m_slots[hole] = m_slots.at(i);
+                hole = i;
+            }
+        }
+        m_slots[hole] = Slot();
+        --m_size;
+    }
+
+    void rehash(int capacity) {
+        QVector<Slot> old;
+        old.swap(m_slots);
+        m_slots.resize(capacity);
+        m_size = 0;
+        for (const Slot &slot : old) {
+            if (slot.used) {
+                const int mask = m_slots.size() - 1;
+                int i = int(qHash(slot.session.address)) & mask;
+                while (m_slots.at(i).used) {
+                    i = (i + 1) & mask;
+                }
+                m_slots[i] = slot;
+                ++m_size;
+            }
+        }
+    }
+
+    QVector<Slot> m_slots;
+    int m_size = 0;
+};
+
+#endif // SESSIONTABLE_H
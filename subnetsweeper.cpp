@@ -0,0 +1,431 @@
+#include "subnetsweeper.h"
+#include "discoverymetrics.h"
+#include "discoverycapture.h"
+
+#include <QHostAddress>
+#include <QDebug>
+#include <QtEndian>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+#ifdef Q_OS_LINUX
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+// 节拍间隔与单次批量大小
+constexpr int SWEEP_TICK_MS = 10;
+constexpr int SWEEP_BATCH = 64;
+// 最多累积 50ms 的发送额度，避免定时器抖动后突发
+constexpr double SWEEP_MAX_BURST_SEC = 0.05;
+// 超过该规模的网段不记录逐地址发送时间（/12 约 8MB）
+constexpr quint64 SWEEP_MAX_TRACKED = 1 << 20;
+// 连续无应答达到该轮数后开始退避，此后每多一轮探测间隔翻倍，最多每 16 轮一次
+constexpr int SWEEP_SILENT_ROUNDS = 3;
+constexpr int SWEEP_MAX_BACKOFF_SHIFT = 4;
+
+namespace {
+quint64 rangeKey(quint64 first, quint64 last)
+{
+    return (first << 32) | last;
+}
+}
+
+SubnetSweeper::SubnetSweeper(QObject *parent)
+    : QObject(parent)
+{
+    m_tickTimer = new QTimer(this);
+    m_tickTimer->setTimerType(Qt::PreciseTimer);
+    m_tickTimer->setInterval(SWEEP_TICK_MS);
+    connect(m_tickTimer, &QTimer::timeout, this, &SubnetSweeper::onTick);
+}
+
+void SubnetSweeper::setRate(int packetsPerSecond)
+{
+    m_rate = qMax(1, packetsPerSecond);
+}
+
+void SubnetSweeper::setPayload(const QByteArray &payload, quint16 port)
+{
+    m_payload = payload;
+    m_port = port;
+}
+
+void SubnetSweeper::addLane(QUdpSocket *socket, quint32 first, quint32 last, quint32 exclude)
+{
+    Lane lane;
+    lane.socket = socket;
+    lane.first = first;
+    lane.last = last;
+    lane.exclude = exclude;
+    lane.silent = m_silentHistory.take(rangeKey(first, last));
+    m_lanes.append(lane);
+}
+
+void SubnetSweeper::clearLanes()
+{
+    stop();
+    for (Lane &lane : m_lanes) {
+        if (!lane.silent.isEmpty()) {
+            m_silentHistory.insert(rangeKey(lane.first, lane.last), lane.silent);
+        }
+    }
+    m_lanes.clear();
+}
+
+void SubnetSweeper::setPriorityAddresses(const QVector<quint32> &addrs)
+{
+    m_priority = addrs;
+    std::sort(m_priority.begin(), m_priority.end());
+    m_priority.erase(std::unique(m_priority.begin(), m_priority.end()), m_priority.end());
+}
+
+void SubnetSweeper::markResponsive(quint32 addr)
+{
+    for (Lane &lane : m_lanes) {
+        if (addr >= lane.first && addr <= lane.last && !lane.silent.isEmpty()) {
+            lane.silent[int(addr - lane.first)] = 0;
+        }
+    }
+}
+
+void SubnetSweeper::forgetSilent()
+{
+    m_silentHistory.clear();
+    for (Lane &lane : m_lanes) {
+        lane.silent.clear();
+    }
+}
+
+void SubnetSweeper::start()
+{
+    ++m_pass;
+    for (Lane &lane : m_lanes) {
+        lane.cursor = lane.first;
+        lane.position = 0;
+        lane.sent = 0;
+        const quint64 span = lane.last >= lane.first ? lane.last - lane.first + 1 : 0;
+        lane.ordered = span > 0 && span <= SWEEP_MAX_TRACKED;
+        if (lane.ordered) {
+            lane.sentAt.fill(-1, int(span));
+            if (lane.silent.size() != int(span)) {
+                lane.silent.fill(0, int(span));
+            }
+            buildOrder(lane);
+            lane.total = quint64(lane.order.size());
+        } else {
+            lane.sentAt.clear();
+            lane.silent.clear();
+            lane.order.clear();
+            lane.total = span;
+            if (lane.exclude >= lane.first && lane.exclude <= lane.last && lane.total > 0) {
+                --lane.total;
+            }
+        }
+    }
+
+    m_nextLane = 0;
+    m_credit = 0;
+    m_clock.start();
+    m_lastTick = 0;
+    m_lastProgress = 0;
+    m_tickTimer->start();
+}
+
+void SubnetSweeper::stop()
+{
+    m_tickTimer->stop();
+}
+
+quint64 SubnetSweeper::sent() const
+{
+    quint64 sum = 0;
+    for (const Lane &lane : m_lanes) {
+        sum += lane.sent;
+    }
+    return sum;
+}
+
+quint64 SubnetSweeper::total() const
+{
+    quint64 sum = 0;
+    for (const Lane &lane : m_lanes) {
+        sum += lane.total;
+    }
+    return sum;
+}
+
+qint64 SubnetSweeper::sentAtUs(quint32 addr) const
+{
+    for (const Lane &lane : m_lanes) {
+        if (addr >= lane.first && addr <= lane.last && !lane.sentAt.isEmpty()) {
+            return lane.sentAt.at(int(addr - lane.first));
+        }
+    }
+    return -1;
+}
+
+namespace {
+// 回放抓包时由回放循环设置的虚拟时钟，-1 表示使用真实时钟
+std::atomic<qint64> g_clockOverrideUs{-1};
+}
+
+void SubnetSweeper::setClockOverride(qint64 us)
+{
+    g_clockOverrideUs.store(us, std::memory_order_relaxed);
+}
+
+qint64 SubnetSweeper::clockUs()
+{
+    const qint64 fixed = g_clockOverrideUs.load(std::memory_order_relaxed);
+    if (fixed >= 0) {
+        return fixed;
+    }
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void SubnetSweeper::onTick()
+{
+    const qint64 now = m_clock.nsecsElapsed();
+    m_credit += m_rate * (now - m_lastTick) / 1e9;
+    m_credit = qMin(m_credit, qMax(1.0, m_rate * SWEEP_MAX_BURST_SEC));
+    m_lastTick = now;
+
+    // 各通道轮流取一批，已完成的通道把额度让给其余通道
+    bool done = true;
+    int blocked = 0;
+    int active = 0;
+    for (const Lane &lane : m_lanes) {
+        active += lane.done() ? 0 : 1;
+    }
+    while (m_credit >= 1.0 && active > blocked) {
+        Lane &lane = m_lanes[m_nextLane];
+        m_nextLane = (m_nextLane + 1) % m_lanes.size();
+        if (lane.done()) {
+            continue;
+        }
+        const int budget = qMin(SWEEP_BATCH, int(m_credit));
+        bool laneBlocked = false;
+        m_credit -= sweepLane(lane, budget, &laneBlocked);
+        if (laneBlocked) {
+            ++blocked;
+            continue;
+        }
+        if (lane.done()) {
+            --active;
+        }
+    }
+    for (const Lane &lane : m_lanes) {
+        done = done && lane.done();
+    }
+
+    if (done || now - m_lastProgress >= 100000000) {
+        m_lastProgress = now;
+        emit progress(sent(), total());
+    }
+    if (done) {
+        m_tickTimer->stop();
+        emit passFinished();
+    }
+}
+
+// 本轮发送顺序：邻居表地址 -> 提示网段 -> 其余地址，后两类跳过退避中的地址
+void SubnetSweeper::buildOrder(Lane &lane) const
+{
+    const int span = int(lane.last - lane.first + 1);
+    QVector<quint8> queued(span, 0);
+    if (lane.exclude >= lane.first && lane.exclude <= lane.last) {
+        queued[int(lane.exclude - lane.first)] = 1;
+    }
+    lane.order.clear();
+
+    auto first = std::lower_bound(m_priority.cbegin(), m_priority.cend(), quint32(lane.first));
+    for (auto it = first; it != m_priority.cend() && *it <= lane.last; ++it) {
+        const int index = int(*it - lane.first);
+        if (!queued.at(index)) {
+            queued[index] = 1;
+            lane.order.append(*it);
+        }
+    }
+
+    auto appendRange = [&](quint64 from, quint64 to) {
+        for (quint64 addr = from; addr <= to; ++addr) {
+            const int index = int(addr - lane.first);
+            if (!queued.at(index)) {
+                queued[index] = 1;
+                if (!backedOff(lane, quint32(addr))) {
+                    lane.order.append(quint32(addr));
+                }
+            }
+        }
+    };
+    for (const auto &range : m_hintRanges) {
+        const quint64 from = qMax<quint64>(range.first, lane.first);
+        const quint64 to = qMin<quint64>(range.second, lane.last);
+        if (from <= to) {
+            appendRange(from, to);
+        }
+    }
+    appendRange(lane.first, lane.last);
+}
+
+// 静默达到阈值的地址每 2^k 轮才探测一次，按地址错开所在的轮次，避免同时集中发送
+bool SubnetSweeper::backedOff(const Lane &lane, quint32 addr) const
+{
+    // 单地址通道（指定目标）始终探测
+    if (lane.first == lane.last) {
+        return false;
+    }
+    const int silent = lane.silent.at(int(addr - lane.first));
+    if (silent < SWEEP_SILENT_ROUNDS) {
+        return false;
+    }
+    const int shift = qMin(silent - SWEEP_SILENT_ROUNDS + 1, SWEEP_MAX_BACKOFF_SHIFT);
+    const quint32 period = 1u << shift;
+    return ((m_pass + addr) & (period - 1)) != 0;
+}
+
+// 返回本次处理的地址数（出错跳过的地址也计入），用于扣减额度；发送缓冲区已满时
+// 置 blocked，已发出的部分照常计入，游标停在未处理的地址上
+int SubnetSweeper::sweepLane(Lane &lane, int budget, bool *blocked)
+{
+    quint32 batch[SWEEP_BATCH];
+    int count = 0;
+    quint64 next = lane.cursor;
+    int position = lane.position;
+    if (lane.ordered) {
+        while (count < budget && position < lane.order.size()) {
+            batch[count++] = lane.order.at(position++);
+        }
+    } else {
+        while (count < budget && next <= lane.last) {
+            const quint32 addr = quint32(next++);
+            if (addr != lane.exclude) {
+                batch[count++] = addr;
+            }
+        }
+    }
+
+    const qint64 stamp = clockUs();
+    if (count > 0 && m_timestampOffset >= 0 && m_payload.size() >= m_timestampOffset + 8) {
+        qToBigEndian<quint64>(quint64(stamp), m_payload.data() + m_timestampOffset);
+    }
+    quint32 sentAddrs[SWEEP_BATCH];
+    int consumed = 0;
+    const int written = count > 0 ? sendBatch(lane.socket, batch, count, sentAddrs, &consumed) : 0;
+    lane.sent += written;
+    if (CaptureWriter *capture = CaptureWriter::active()) {
+        for (int i = 0; i < written; ++i) {
+            capture->append(CaptureKind::ProbeSent, DeviceAddress::fromIpv4(sentAddrs[i]), m_port,
+                            m_payload.constData(), m_payload.size());
+        }
+    }
+    if (lane.ordered) {
+        // 先记为静默一轮，收到应答时由 markResponsive 清零
+        for (int i = 0; i < written; ++i) {
+            const int index = int(sentAddrs[i] - lane.first);
+            lane.sentAt[index] = stamp;
+            if (lane.silent.at(index) < 255) {
+                ++lane.silent[index];
+            }
+        }
+        lane.position += consumed;
+        *blocked = consumed < count;
+        return consumed;
+    }
+    if (consumed < count) {
+        if (consumed > 0) {
+            lane.cursor = quint64(batch[consumed - 1]) + 1;
+        }
+        *blocked = true;
+        return consumed;
+    }
+    lane.cursor = next;
+    return consumed;
+}
+
+// 返回实际被内核接受的包数并把对应地址写入 accepted；consumed 为已处理（含出错跳过）的地址数
+int SubnetSweeper::sendBatch(QUdpSocket *socket, const quint32 *addrs, int count,
+                             quint32 *accepted, int *consumed)
+{
+#ifdef Q_OS_LINUX
+    const qintptr fd = socket->socketDescriptor();
+    sockaddr_storage local;
+    socklen_t localLen = sizeof(local);
+    if (fd != -1 && ::getsockname(int(fd), reinterpret_cast<sockaddr *>(&local), &localLen) == 0) {
+        // QUdpSocket 绑定 Any 时为双栈 IPv6 套接字，需使用 IPv4 映射地址
+        const bool v6 = local.ss_family == AF_INET6;
+        mmsghdr msgs[SWEEP_BATCH];
+        iovec iov[SWEEP_BATCH];
+        sockaddr_in6 dest[SWEEP_BATCH];
+        std::memset(msgs, 0, sizeof(mmsghdr) * count);
+        std::memset(dest, 0, sizeof(sockaddr_in6) * count);
+
+        for (int i = 0; i < count; ++i) {
+            if (v6) {
+                dest[i].sin6_family = AF_INET6;
+                dest[i].sin6_port = htons(m_port);
+                dest[i].sin6_addr.s6_addr[10] = 0xff;
+                dest[i].sin6_addr.s6_addr[11] = 0xff;
+                const quint32 be = htonl(addrs[i]);
+                std::memcpy(&dest[i].sin6_addr.s6_addr[12], &be, 4);
+                msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in6);
+            } else {
+                sockaddr_in *in = reinterpret_cast<sockaddr_in *>(&dest[i]);
+                in->sin_family = AF_INET;
+                in->sin_port = htons(m_port);
+                in->sin_addr.s_addr = htonl(addrs[i]);
+                msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            }
+            iov[i].iov_base = const_cast<char *>(m_payload.constData());
+            iov[i].iov_len = size_t(m_payload.size());
+            msgs[i].msg_hdr.msg_name = &dest[i];
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int offset = 0;
+        int sent = 0;
+        while (offset < count) {
+            const int n = ::sendmmsg(int(fd), msgs + offset, unsigned(count - offset), MSG_DONTWAIT);
+            if (n > 0) {
+                std::memcpy(accepted + sent, addrs + offset, sizeof(quint32) * size_t(n));
+                offset += n;
+                sent += n;
+                countMetric(MetricCounter::ProbesSent, quint64(n));
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+                countMetric(MetricCounter::SendBlocked);
+                break;
+            }
+            // 单个地址不可达等错误：跳过该地址继续发送，不计入已发出
+            countMetric(MetricCounter::SendErrors);
+            ++offset;
+        }
+        *consumed = offset;
+        return sent;
+    }
+#endif
+    int offset = 0;
+    int sent = 0;
+    for (; offset < count; ++offset) {
+        if (socket->writeDatagram(m_payload, QHostAddress(addrs[offset]), m_port) < 0) {
+            if (socket->error() == QAbstractSocket::TemporaryError) {
+                countMetric(MetricCounter::SendBlocked);
+                break;
+            }
+            countMetric(MetricCounter::SendErrors);
+        } else {
+            accepted[sent++] = addrs[offset];
+            countMetric(MetricCounter::ProbesSent);
+        }
+    }
+    *consumed = offset;
+    return sent;
+}
@@ -0,0 +1,114 @@
+#ifndef SUBNETSWEEPER_H
+#define SUBNETSWEEPER_H
+
+#include <QObject>
+#include <QUdpSocket>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QByteArray>
+#include <QVector>
+#include <QPair>
+#include <QHash>
+
+// 按地址游标逐段发送探测包，发送速率受每秒包数预算限制。
+// 每个网卡一条扫描通道（lane），所有通道轮流共享同一预算。
+// 可记录逐地址状态的通道按候选顺序发送：邻居表中的地址、提示网段（如 DHCP 地址池）、
+// 其余地址；连续多轮无应答的地址降低探测频率。
+class SubnetSweeper : public QObject {
+    Q_OBJECT
+
+public:
+    explicit SubnetSweeper(QObject *parent = nullptr);
+
+    void setRate(int packetsPerSecond);
+    int rate() const { return m_rate; }
+
+    void setPayload(const QByteArray &payload, quint16 port);
+    // 每批发送前在 payload 的该偏移处写入 clockUs()（大端 u64），-1 表示不写
+    void setTimestampOffset(int offset) { m_timestampOffset = offset; }
+
+    // 通过 socket 扫描闭区间 [first, last]，跳过 exclude（本机地址）
+    void addLane(QUdpSocket *socket, quint32 first, quint32 last, quint32 exclude = 0);
+    void clearLanes();
+
+    // 优先探测的地址（如内核 ARP 表中的主机），不受静默退避影响
+    void setPriorityAddresses(const QVector<quint32> &addrs);
+    // 排在其余地址之前探测的闭区间，如配置的 DHCP 地址池
+    void setHintRanges(const QVector<QPair<quint32, quint32>> &ranges) { m_hintRanges = ranges; }
+
+    // 收到 addr 的应答，清除其静默计数
+    void markResponsive(quint32 addr);
+    // 清除所有地址的静默计数，下一轮恢复完整扫描
+    void forgetSilent();
+
+    void start();
+    void stop();
+    bool isRunning() const { return m_tickTimer->isActive(); }
+
+    quint64 sent() const;
+    quint64 total() const;
+
+    // 本轮向 addr 发送探测的时刻（clockUs），未发送或未记录时返回 -1
+    qint64 sentAtUs(quint32 addr) const;
+    static qint64 clockUs();
+
+    // 让 clockUs() 返回固定值，供离线回放重现 RTT；传 -1 恢复真实时钟
+    static void setClockOverride(qint64 us);
+
+signals:
+    void progress(quint64 sent, quint64 total);
+    // 所有通道完成一轮扫描
+    void passFinished();
+
+private slots:
+    void onTick();
+
+private:
+    struct Lane {
+        QUdpSocket *socket = nullptr;
+        quint64 first = 0;
+        quint64 cursor = 0;
+        quint64 last = 0;
+        quint32 exclude = 0;
+        quint64 sent = 0;
+        quint64 total = 0;
+        QVector<qint64> sentAt;     // 按 addr - first 索引，用于计算 RTT
+        QVector<quint8> silent;     // 按 addr - first 索引，发出后未获应答的轮数
+
+        // 有序通道按 order 发送；地址过多不记录状态的通道按 cursor 线性发送
+        bool ordered = false;
+        QVector<quint32> order;
+        int position = 0;
+
+        bool done() const { return ordered ? position >= order.size() : cursor > last; }
+    };
+
+    void buildOrder(Lane &lane) const;
+    bool backedOff(const Lane &lane, quint32 addr) const;
+    int sweepLane(Lane &lane, int budget, bool *blocked);
+    int sendBatch(QUdpSocket *socket, const quint32 *addrs, int count,
+                  quint32 *accepted, int *consumed);
+
+    QVector<Lane> m_lanes;
+    int m_nextLane = 0;
+
+    QVector<quint32> m_priority;    // 升序
+    QVector<QPair<quint32, quint32>> m_hintRanges;
+    // clearLanes 后按 (first << 32 | last) 保留各通道的静默计数，供下一轮复用
+    QHash<quint64, QVector<quint8>> m_silentHistory;
+    quint32 m_pass = 0;
+
+    QTimer *m_tickTimer;
+    QElapsedTimer m_clock;
+
+    QByteArray m_payload;
+    quint16 m_port = 0;
+    int m_timestampOffset = -1;
+
+    int m_rate = 1000;
+    double m_credit = 0;
+    qint64 m_lastTick = 0;
+    qint64 m_lastProgress = 0;
+};
+
+#endif // SUBNETSWEEPER_H
@@ -0,0 +1,145 @@
+#include "targetspec.h"
+
+#include <QRegularExpression>
+#include <QStringList>
+
+#include <algorithm>
+
+void IntervalSet::add(quint32 first, quint32 last)
+{
+    if (first > last) {
+        return;
+    }
+    // 找到第一个可能与 [first, last] 相交或相邻的区间，向后吞并
+    auto it = std::lower_bound(m_ranges.begin(), m_ranges.end(), first,
+                               [](const QPair<quint32, quint32> &range, quint32 addr) {
+        return range.second < addr && range.second + 1 < addr;
+    });
+    const int index = int(it - m_ranges.begin());
+    int end = index;
+    while (end < m_ranges.size() && (last == 0xffffffffu || m_ranges.at(end).first <= last + 1)) {
+        first = qMin(first, m_ranges.at(end).first);
+        last = qMax(last, m_ranges.at(end).second);
+        ++end;
+    }
+    m_ranges.remove(index, end - index);
+    m_ranges.insert(index, qMakePair(first, last));
+}
+
+void IntervalSet::add(const IntervalSet &other)
+{
+    for (const auto &range : other.m_ranges) {
+        add(range.first, range.second);
+    }
+}
+
+bool IntervalSet::contains(quint32 addr) const
+{
+    auto it = std::lower_bound(m_ranges.cbegin(), m_ranges.cend(), addr,
+                               [](const QPair<quint32, quint32> &range, quint32 value) {
+        return range.second < value;
+    });
+    return it != m_ranges.cend() && it->first <= addr;
+}
+
+quint64 IntervalSet::size() const
+{
+    quint64 total = 0;
+    for (const auto &range : m_ranges) {
+        total += quint64(range.second - range.first) + 1;
+    }
+    return total;
+}
+
+namespace {
+// 严格的点分十进制 IPv4，不接受 QHostAddress 允许的简写形式
+bool parseIpv4(const QString &text, quint32 *addr)
+{
+    const QStringList parts = text.split('.');
+    if (parts.size() != 4) {
+        return false;
+    }
+    quint32 value = 0;
+    for (const QString &part : parts) {
+        bool ok = false;
+        const uint octet = part.toUInt(&ok);
+        if (!ok || part.isEmpty() || part.size() > 3 || octet > 255) {
+            return false;
+        }
+        value = (value << 8) | octet;
+    }
+    *addr = value;
+    return true;
+}
+
+bool parseItem(const QString &item, IntervalSet *out)
+{
+    const int slash = item.indexOf('/');
+    if (slash >= 0) {
+        quint32 addr = 0;
+        bool ok = false;
+        const int prefix = item.mid(slash + 1).toInt(&ok);
+        if (!parseIpv4(item.left(slash), &addr) || !ok || prefix < 0 || prefix > 32) {
+            return false;
+        }
+        const quint32 mask = prefix == 0 ? 0 : ~quint32(0) << (32 - prefix);
+        const quint32 network = addr & mask;
+        const quint32 broadcast = network | ~mask;
+        if (prefix <= 30) {
+            out->add(network + 1, broadcast - 1);
+        } else {
+            out->add(network, broadcast);
+        }
+        return true;
+    }
+
+    const int dash = item.indexOf('-');
+    if (dash >= 0) {
+        quint32 first = 0;
+        quint32 last = 0;
+        const QString tail = item.mid(dash + 1);
+        if (!parseIpv4(item.left(dash), &first)) {
+            return false;
+        }
+        if (!tail.contains('.')) {
+            bool ok = false;
+            const uint octet = tail.toUInt(&ok);
+            if (!ok || tail.size() > 3 || octet > 255) {
+                return false;
+            }
+            last = (first & 0xffffff00u) | octet;
+        } else if (!parseIpv4(tail, &last)) {
+            return false;
+        }
+        if (last < first) {
+            return false;
+        }
+        out->add(first, last);
+        return true;
+    }
+
+    quint32 addr = 0;
+    if (!parseIpv4(item, &addr)) {
+        return false;
+    }
+    out->add(addr, addr);
+    return true;
+}
+}
+
+bool TargetSpec::parse(const QString &spec, IntervalSet *out, QString *error)
+{
+    static const QRegularExpression separators(QStringLiteral("[,;\\s]+"));
+    const QStringList items = spec.split(separators, Qt::SkipEmptyParts);
+    IntervalSet parsed;
+    for (const QString &item : items) {
+        if (!parseItem(item, &parsed)) {
+            if (error) {
+                *error = QStringLiteral("Invalid target: %1").arg(item);
+            }
+            return false;
+        }
+    }
+    out->add(parsed);
+    return true;
+}
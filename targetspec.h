@@ -0,0 +1,38 @@
+#ifndef TARGETSPEC_H
+#define TARGETSPEC_H
+
+#include <QString>
+#include <QVector>
+#include <QPair>
+
+// 一组互不重叠、按升序排列的 IPv4 闭区间；相交或相邻的区间在加入时合并，
+// 因此重叠的目标在一轮扫描中只探测一次
+class IntervalSet {
+public:
+    void add(quint32 first, quint32 last);
+    void add(const IntervalSet &other);
+    void clear() { m_ranges.clear(); }
+
+    bool isEmpty() const { return m_ranges.isEmpty(); }
+    bool contains(quint32 addr) const;
+    // 地址总数
+    quint64 size() const;
+
+    const QVector<QPair<quint32, quint32>> &ranges() const { return m_ranges; }
+
+private:
+    QVector<QPair<quint32, quint32>> m_ranges;
+};
+
+namespace TargetSpec {
+
+// 解析以逗号或空白分隔的目标列表，每项可以是：
+//   单个主机    10.1.9.17
+//   CIDR 网段   10.1.4.0/24（/30 及更大的网段不含网络地址与广播地址）
+//   地址区间    10.1.0.10-10.1.0.99，或只写末段 10.1.0.10-99
+// 成功时结果并入 out；失败时 out 不变，error 说明出错的项
+bool parse(const QString &spec, IntervalSet *out, QString *error = nullptr);
+
+}
+
+#endif // TARGETSPEC_H
@@ -0,0 +1,65 @@
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <QHash>
+#include <QVector>
+
+// 哈希时间轮：所有超时共用一个节拍源，每个 key 在轮中只占一项。
+// schedule() 对已存在的 key 只更新截止时刻，到槽时再按新时刻重新入槽，
+// 因此频繁刷新（如每次收到数据）是 O(1) 且不增加内存
+template <typename Key>
+class TimerWheel {
+public:
+    explicit TimerWheel(int slots = 64) : m_slots(qMax(1, slots)) {}
+
+    // ticks 个节拍后超时
+    void schedule(const Key &key, int ticks) {
+        const quint64 deadline = m_tick + quint64(qMax(1, ticks));
+        auto it = m_deadlines.find(key);
+        if (it != m_deadlines.end()) {
+            const bool earlier = deadline < *it;
+            *it = deadline;
+            // 截止时刻提前时原槽位太晚，额外入槽一次；旧项到期时按哈希表判断为残留
+            if (!earlier) {
+                return;
+            }
+        } else {
+            m_deadlines.insert(key, deadline);
+        }
+        m_slots[int(deadline % quint64(m_slots.size()))].append(key);
+    }
+
+    // 惰性删除：槽中残留项在到期处理时丢弃
+    void cancel(const Key &key) { m_deadlines.remove(key); }
+
+    bool contains(const Key &key) const { return m_deadlines.contains(key); }
+    int size() const { return m_deadlines.size(); }
+    quint64 currentTick() const { return m_tick; }
+
+    // 前进一个节拍，对到期的 key 调用 expired(key)
+    template <typename Callback>
+    void advance(Callback expired) {
+        ++m_tick;
+        QVector<Key> due;
+        due.swap(m_slots[int(m_tick % quint64(m_slots.size()))]);
+        for (const Key &key : due) {
+            auto it = m_deadlines.find(key);
+            if (it == m_deadlines.end()) {
+                continue;
+            }
+            if (*it <= m_tick) {
+                m_deadlines.erase(it);
+                expired(key);
+            } else {
+                m_slots[int(*it % quint64(m_slots.size()))].append(key);
+            }
+        }
+    }
+
+private:
+    QVector<QVector<Key>> m_slots;
+    QHash<Key, quint64> m_deadlines;
+    quint64 m_tick = 0;
+};
+
+#endif // TIMERWHEEL_H